@@ -53,14 +53,18 @@ private:
 
 using ParamDeclPtr = std::unique_ptr<ParamDecl>;
 
-/// Declaration of a function
+/// Declaration of a function, with the names of its annotations (such as
+/// inline in @inline) in source order
 struct FunctionDecl final : public Decl {
-  FunctionDecl(source::Text name, std::vector<ParamDeclPtr> params,
-               CompoundStmtPtr body, source::Range range)
-      : Decl{Kind::FunctionDecl, range}, Name{name}, Params{std::move(params)},
+  FunctionDecl(source::Text name, std::vector<source::Text> annotations,
+               std::vector<ParamDeclPtr> params, CompoundStmtPtr body,
+               source::Range range)
+      : Decl{Kind::FunctionDecl, range}, Name{name},
+        Annotations{std::move(annotations)}, Params{std::move(params)},
         Body{std::move(body)} {}
 
   source::Text getName() const { return Name; }
+  llvm::ArrayRef<source::Text> getAnnotations() const { return Annotations; }
   llvm::ArrayRef<ParamDeclPtr> getParams() const { return Params; }
   const CompoundStmt *getBody() const { return Body.get(); }
 
@@ -70,6 +74,7 @@ struct FunctionDecl final : public Decl {
 
 private:
   source::Text Name;
+  std::vector<source::Text> Annotations;
   std::vector<ParamDeclPtr> Params;
   CompoundStmtPtr Body;
 };
@@ -94,6 +94,12 @@ struct BinaryExpr final : public Expr {
     Sub,
     Mul,
     Div,
+    Less,
+    LessEqual,
+    Greater,
+    GreaterEqual,
+    Equal,
+    NotEqual,
   };
 
   BinaryExpr(Op op, ExprPtr lhs, ExprPtr rhs, source::Range range)
@@ -114,8 +120,35 @@ private:
   ExprPtr RHS;
 };
 
+/// Whether the operator compares its operands, giving 1 if the comparison
+/// holds and 0 otherwise. Comparisons involving a NaN only hold for ~=
+bool IsComparison(BinaryExpr::Op);
+
 llvm::raw_ostream &operator<<(llvm::raw_ostream &, BinaryExpr::Op);
 
+/// Expression representing `if Cond then Then else Else`, whose value is Then
+/// if Cond is not zero and Else otherwise. Only the selected branch is
+/// evaluated
+struct ConditionalExpr final : public Expr {
+  ConditionalExpr(ExprPtr cond, ExprPtr thenExpr, ExprPtr elseExpr,
+                  source::Range range)
+      : Expr{Kind::ConditionalExpr, range}, Cond{std::move(cond)},
+        Then{std::move(thenExpr)}, Else{std::move(elseExpr)} {}
+
+  const Expr *getCond() const { return Cond.get(); }
+  const Expr *getThen() const { return Then.get(); }
+  const Expr *getElse() const { return Else.get(); }
+
+  static bool classof(const Node *n) {
+    return n->getKind() == Kind::ConditionalExpr;
+  }
+
+private:
+  ExprPtr Cond;
+  ExprPtr Then;
+  ExprPtr Else;
+};
+
 } // namespace mua::ast
 
 #endif // MUA_AST_EXPR_H
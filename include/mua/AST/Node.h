@@ -36,14 +36,16 @@ struct Node {
     IdentifierExpr,
     CallExpr,
     BinaryExpr,
-    LastExpr = BinaryExpr,
+    ConditionalExpr,
+    LastExpr = ConditionalExpr,
 
     // Statements
     FirstStmt,
     ExprStmt = FirstStmt,
     ReturnStmt,
     CompoundStmt,
-    LastStmt = CompoundStmt,
+    ForStmt,
+    LastStmt = ForStmt,
 
     // Declarations
     FirstDecl,
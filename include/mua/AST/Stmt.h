@@ -85,6 +85,29 @@ private:
 
 using CompoundStmtPtr = std::unique_ptr<CompoundStmt>;
 
+/// Statement representing `for Var = Start, End do Body end`. Start and End are
+/// evaluated once, then Body runs with Var set to Start, Start + 1, ... up to
+/// End. Var is local to the loop
+struct ForStmt final : public Stmt {
+  ForStmt(source::Text var, ExprPtr start, ExprPtr end, CompoundStmtPtr body,
+          source::Range range)
+      : Stmt{Kind::ForStmt, range}, Var{var}, Start{std::move(start)},
+        End{std::move(end)}, Body{std::move(body)} {}
+
+  source::Text getVar() const { return Var; }
+  const Expr *getStart() const { return Start.get(); }
+  const Expr *getEnd() const { return End.get(); }
+  const CompoundStmt *getBody() const { return Body.get(); }
+
+  static bool classof(const Node *n) { return n->getKind() == Kind::ForStmt; }
+
+private:
+  source::Text Var;
+  ExprPtr Start;
+  ExprPtr End;
+  CompoundStmtPtr Body;
+};
+
 } // namespace mua::ast
 
 #endif // MUA_AST_STMT_H
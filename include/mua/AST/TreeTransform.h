@@ -0,0 +1,195 @@
+// MIT License
+//
+// Copyright (c) 2026-onwards Iñaki Amatria-Barral
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef MUA_AST_TREETRANSFORM_H
+#define MUA_AST_TREETRANSFORM_H
+
+#include "mua/AST/TranslationUnit.h"
+#include "mua/Support/ErrorHandling.h"
+
+namespace mua::ast {
+
+/// Generic AST rebuilder. Derived classes hide the transform functions of the
+/// Nodes they rewrite, and by default every Node is copied. Transforms of
+/// children are dispatched through the Derived class
+template <typename Derived> struct TreeTransform {
+  ExprPtr transformExpr(const Expr &expr) {
+    switch (expr.getKind()) {
+    case Node::Kind::NumberExpr:
+      return getDerived().transformNumberExpr(
+          static_cast<const NumberExpr &>(expr));
+    case Node::Kind::IdentifierExpr:
+      return getDerived().transformIdentifierExpr(
+          static_cast<const IdentifierExpr &>(expr));
+    case Node::Kind::CallExpr:
+      return getDerived().transformCallExpr(
+          static_cast<const CallExpr &>(expr));
+    case Node::Kind::BinaryExpr:
+      return getDerived().transformBinaryExpr(
+          static_cast<const BinaryExpr &>(expr));
+    case Node::Kind::ConditionalExpr:
+      return getDerived().transformConditionalExpr(
+          static_cast<const ConditionalExpr &>(expr));
+    case Node::Kind::ExprStmt:
+    case Node::Kind::ReturnStmt:
+    case Node::Kind::CompoundStmt:
+    case Node::Kind::ForStmt:
+    case Node::Kind::ParamDecl:
+    case Node::Kind::FunctionDecl:
+    case Node::Kind::TranslationUnit:
+      break;
+    }
+    MUA_COVERS_ALL_CASES;
+  }
+
+  ExprPtr transformNumberExpr(const NumberExpr &ne) {
+    return std::make_unique<NumberExpr>(ne.getValue(), ne.getRange());
+  }
+
+  ExprPtr transformIdentifierExpr(const IdentifierExpr &id) {
+    return std::make_unique<IdentifierExpr>(id.getName());
+  }
+
+  ExprPtr transformCallExpr(const CallExpr &call) {
+    std::vector<ExprPtr> args;
+    for (const ExprPtr &arg : call.getArgs()) {
+      args.push_back(getDerived().transformExpr(*arg));
+    }
+    return std::make_unique<CallExpr>(call.getCallee(), std::move(args),
+                                      call.getRange());
+  }
+
+  ExprPtr transformBinaryExpr(const BinaryExpr &bin) {
+    ExprPtr lhs{getDerived().transformExpr(*bin.getLHS())};
+    ExprPtr rhs{getDerived().transformExpr(*bin.getRHS())};
+    return std::make_unique<BinaryExpr>(bin.getOp(), std::move(lhs),
+                                        std::move(rhs), bin.getRange());
+  }
+
+  ExprPtr transformConditionalExpr(const ConditionalExpr &cond) {
+    ExprPtr condExpr{getDerived().transformExpr(*cond.getCond())};
+    ExprPtr thenExpr{getDerived().transformExpr(*cond.getThen())};
+    ExprPtr elseExpr{getDerived().transformExpr(*cond.getElse())};
+    return std::make_unique<ConditionalExpr>(std::move(condExpr),
+                                             std::move(thenExpr),
+                                             std::move(elseExpr),
+                                             cond.getRange());
+  }
+
+  StmtPtr transformStmt(const Stmt &stmt) {
+    switch (stmt.getKind()) {
+    case Node::Kind::ExprStmt:
+      return getDerived().transformExprStmt(
+          static_cast<const ExprStmt &>(stmt));
+    case Node::Kind::ReturnStmt:
+      return getDerived().transformReturnStmt(
+          static_cast<const ReturnStmt &>(stmt));
+    case Node::Kind::CompoundStmt:
+      return getDerived().transformCompoundStmt(
+          static_cast<const CompoundStmt &>(stmt));
+    case Node::Kind::ForStmt:
+      return getDerived().transformForStmt(static_cast<const ForStmt &>(stmt));
+    case Node::Kind::NumberExpr:
+    case Node::Kind::IdentifierExpr:
+    case Node::Kind::CallExpr:
+    case Node::Kind::BinaryExpr:
+    case Node::Kind::ConditionalExpr:
+    case Node::Kind::ParamDecl:
+    case Node::Kind::FunctionDecl:
+    case Node::Kind::TranslationUnit:
+      break;
+    }
+    MUA_COVERS_ALL_CASES;
+  }
+
+  StmtPtr transformExprStmt(const ExprStmt &es) {
+    return std::make_unique<ExprStmt>(
+        getDerived().transformExpr(*es.getExpr()));
+  }
+
+  StmtPtr transformReturnStmt(const ReturnStmt &rs) {
+    return std::make_unique<ReturnStmt>(
+        getDerived().transformExpr(*rs.getValue()), rs.getRange());
+  }
+
+  CompoundStmtPtr transformCompoundStmt(const CompoundStmt &cs) {
+    std::vector<StmtPtr> stmts;
+    for (const StmtPtr &stmt : cs.getStmts()) {
+      stmts.push_back(getDerived().transformStmt(*stmt));
+    }
+    return std::make_unique<CompoundStmt>(std::move(stmts), cs.getRange());
+  }
+
+  StmtPtr transformForStmt(const ForStmt &fs) {
+    ExprPtr start{getDerived().transformExpr(*fs.getStart())};
+    ExprPtr end{getDerived().transformExpr(*fs.getEnd())};
+    CompoundStmtPtr body{getDerived().transformCompoundStmt(*fs.getBody())};
+    return std::make_unique<ForStmt>(fs.getVar(), std::move(start),
+                                     std::move(end), std::move(body),
+                                     fs.getRange());
+  }
+
+  ParamDeclPtr transformParamDecl(const ParamDecl &pd) {
+    return std::make_unique<ParamDecl>(pd.getName());
+  }
+
+  FunctionDeclPtr transformFunctionDecl(const FunctionDecl &fn) {
+    std::vector<ParamDeclPtr> params;
+    for (const ParamDeclPtr &pd : fn.getParams()) {
+      params.push_back(getDerived().transformParamDecl(*pd));
+    }
+    CompoundStmtPtr body{getDerived().transformCompoundStmt(*fn.getBody())};
+    return std::make_unique<FunctionDecl>(
+        fn.getName(),
+        std::vector<source::Text>{fn.getAnnotations().begin(),
+                                  fn.getAnnotations().end()},
+        std::move(params), std::move(body), fn.getRange());
+  }
+
+  std::unique_ptr<TranslationUnit>
+  transformTranslationUnit(const TranslationUnit &tu) {
+    std::vector<FunctionDeclPtr> fns;
+    for (const FunctionDeclPtr &fn : tu.getFNs()) {
+      fns.push_back(getDerived().transformFunctionDecl(*fn));
+    }
+    return std::make_unique<TranslationUnit>(std::move(fns), tu.getRange());
+  }
+
+private:
+  Derived &getDerived() { return static_cast<Derived &>(*this); }
+};
+
+/// Deep copy of an Expression
+inline ExprPtr Clone(const Expr &expr) {
+  struct Cloner final : public TreeTransform<Cloner> {};
+  return Cloner{}.transformExpr(expr);
+}
+
+/// Deep copy of a Statement
+inline StmtPtr Clone(const Stmt &stmt) {
+  struct Cloner final : public TreeTransform<Cloner> {};
+  return Cloner{}.transformStmt(stmt);
+}
+
+} // namespace mua::ast
+
+#endif // MUA_AST_TREETRANSFORM_H
@@ -66,6 +66,9 @@ template <typename Visitor> struct Walker final {
     case Node::Kind::BinaryExpr:
       walkChildren(static_cast<const BinaryExpr &>(n));
       break;
+    case Node::Kind::ConditionalExpr:
+      walkChildren(static_cast<const ConditionalExpr &>(n));
+      break;
     case Node::Kind::ExprStmt:
       walkChildren(static_cast<const ExprStmt &>(n));
       break;
@@ -75,6 +78,9 @@ template <typename Visitor> struct Walker final {
     case Node::Kind::CompoundStmt:
       walkChildren(static_cast<const CompoundStmt &>(n));
       break;
+    case Node::Kind::ForStmt:
+      walkChildren(static_cast<const ForStmt &>(n));
+      break;
     case Node::Kind::ParamDecl:
       walkChildren(static_cast<const ParamDecl &>(n));
       break;
@@ -129,6 +135,15 @@ private:
     }
   }
 
+  void walkChildren(const ConditionalExpr &cond) {
+    if (TheVisitor.onEnter(cond)) {
+      walk(*cond.getCond());
+      walk(*cond.getThen());
+      walk(*cond.getElse());
+      TheVisitor.onExit(cond);
+    }
+  }
+
   void walkChildren(const ExprStmt &es) {
     if (TheVisitor.onEnter(es)) {
       walk(*es.getExpr());
@@ -152,6 +167,15 @@ private:
     }
   }
 
+  void walkChildren(const ForStmt &fs) {
+    if (TheVisitor.onEnter(fs)) {
+      walk(*fs.getStart());
+      walk(*fs.getEnd());
+      walk(*fs.getBody());
+      TheVisitor.onExit(fs);
+    }
+  }
+
   void walkChildren(const ParamDecl &pd) {
     if (TheVisitor.onEnter(pd)) {
       TheVisitor.onExit(pd);
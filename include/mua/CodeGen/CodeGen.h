@@ -0,0 +1,155 @@
+// MIT License
+//
+// Copyright (c) 2026-onwards Iñaki Amatria-Barral
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef MUA_CODEGEN_CODEGEN_H
+#define MUA_CODEGEN_CODEGEN_H
+
+#include "mua/Lower/Lower.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/Support/CodeGen.h"
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace llvm {
+class TargetMachine;
+class raw_fd_ostream;
+class raw_ostream;
+} // namespace llvm
+
+namespace mua::lower {
+struct IRUnit;
+} // namespace mua::lower
+
+namespace mua::codegen {
+
+/// Options selecting the target to generate native code for
+struct TargetOptions final {
+  /// Target triple. If empty, the triple of the host is used
+  std::string Triple;
+  /// Target CPU. "native" selects the CPU of the host and all of its features
+  std::string CPU{"generic"};
+  llvm::Reloc::Model RelocModel{llvm::Reloc::PIC_};
+  /// Optimization level of the code generator
+  lower::OptLevel Level{lower::OptLevel::O0};
+};
+
+/// Create a TargetMachine for the given options. On failure, returns nullptr
+/// and writes diagnostics to the provided output stream
+std::unique_ptr<llvm::TargetMachine> CreateTargetMachine(const TargetOptions &,
+                                                         llvm::raw_ostream &);
+
+/// Set the target triple and data layout of the Module of an IRUnit. Must be
+/// done before optimizing, so that passes know about the target
+void SetTarget(lower::IRUnit &, const llvm::TargetMachine &);
+
+/// Clone every function of the Module of an IRUnit for each of the given
+/// x86-64 microarchitecture levels (x86-64-v2, x86-64-v3 or x86-64-v4). Each
+/// exported function, and each function whose address is in a constant such
+/// as the dispatch table, becomes an ifunc whose resolver picks, once at load
+/// time, the clone of the best level supported by the CPU. The target of the
+/// Module must already be set to an x86-64 ELF target. On failure, returns
+/// false and writes diagnostics to the provided output stream
+bool Multiversion(lower::IRUnit &, llvm::ArrayRef<std::string>,
+                  llvm::raw_ostream &);
+
+/// Kinds of native files that may be emitted
+enum class FileKind { Assembly, Object };
+
+/// Generate native code for the Module of an IRUnit and write it to the given
+/// output stream. On failure, returns false and writes diagnostics to the
+/// provided output stream
+bool Emit(lower::IRUnit &, llvm::TargetMachine &, FileKind,
+          llvm::raw_fd_ostream &, llvm::raw_ostream &);
+
+/// Generate an object file for the Module of an IRUnit and write it to the
+/// given output stream as a static archive of a single member, so that it can
+/// be linked into C and C++ programs like any library. On failure, returns
+/// false and writes diagnostics to the provided output stream
+bool EmitLibrary(lower::IRUnit &, llvm::TargetMachine &, llvm::raw_fd_ostream &,
+                 llvm::raw_ostream &);
+
+/// Options splitting a Module into partitions compiled in parallel
+struct ParallelOptions final {
+  /// Number of threads to compile partitions on. If zero, one per hardware
+  /// thread. Never changes the output
+  unsigned Threads{0};
+  /// Number of instructions from which a partition is not grown any further
+  unsigned PartitionSize{1000};
+};
+
+/// Split the Module of an IRUnit into partitions of functions that call each
+/// other, optimize each partition in its own LLVMContext on a thread pool and
+/// link them back, in order, into the Module. If TargetOptions are provided,
+/// the partitions are optimized for that target
+void OptimizeInParallel(lower::IRUnit &, lower::OptLevel,
+                        const TargetOptions *, const ParallelOptions &);
+
+/// Split the Module of an IRUnit into partitions as OptimizeInParallel does,
+/// optimize them at the level of the TargetOptions and generate an object file
+/// for each of them on a thread pool. The objects are written to the given
+/// output stream as a static archive, in partition order. On failure, returns
+/// false and writes diagnostics to the provided output stream
+bool EmitArchive(lower::IRUnit &, const TargetOptions &,
+                 const ParallelOptions &, llvm::raw_fd_ostream &,
+                 llvm::raw_ostream &);
+
+/// Static cost of a function, estimated with the cost model of a target.
+/// Instructions the cost model cannot cost count as free
+struct FunctionCost final {
+  std::string Name;
+  std::int64_t Instructions;
+  /// Sum of the reciprocal throughputs of every instruction, each executed once
+  std::int64_t Throughput;
+  /// Latency of the longest chain of dependent instructions, through every
+  /// loop body once
+  std::int64_t Latency;
+  /// Calls to other functions, intrinsics excluded
+  std::int64_t Calls;
+};
+
+/// Estimate the cost of every function defined in the Module of an IRUnit, in
+/// Module order, with the cost model of the given TargetMachine
+std::vector<FunctionCost> EstimateCosts(const lower::IRUnit &,
+                                        llvm::TargetMachine &);
+
+/// Formats of cost reports
+enum class CostFormat { Text, JSON };
+
+/// Write a report of the given costs to the given output stream. If baseline
+/// costs are provided, such as those of an earlier report, every cost is
+/// reported with its change from the baseline, and functions only in the
+/// baseline are reported as removed
+void WriteCostReport(llvm::ArrayRef<FunctionCost>,
+                     const std::vector<FunctionCost> *, CostFormat,
+                     llvm::raw_ostream &);
+
+/// Read the costs of the JSON report in the given file. On failure, returns
+/// std::nullopt and writes diagnostics to the provided output stream
+std::optional<std::vector<FunctionCost>> ReadCostReport(llvm::StringRef,
+                                                        llvm::raw_ostream &);
+
+} // namespace mua::codegen
+
+#endif // MUA_CODEGEN_CODEGEN_H
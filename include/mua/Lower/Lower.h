@@ -23,7 +23,14 @@
 #ifndef MUA_LOWER_LOWER_H
 #define MUA_LOWER_LOWER_H
 
+#include "mua/Support/FPPrecision.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
+#include <string>
+#include <vector>
+
 namespace llvm {
+class TargetMachine;
 class raw_ostream;
 } // namespace llvm
 
@@ -39,14 +46,120 @@ namespace mua::lower {
 
 struct IRUnit;
 
+/// Floating-point models, from the most to the least conservative
+enum class FPModel {
+  /// IEEE semantics, with the dynamic rounding mode and floating-point
+  /// exceptions observable: operations are never reordered nor removed
+  Strict,
+  /// IEEE semantics in the default environment: every operation is correctly
+  /// rounded as written
+  Precise,
+  /// Every fast-math flag: operations may be reassociated, approximated and
+  /// assumed to be neither NaN nor infinite
+  Fast,
+};
+
+/// Fusion of multiplications and additions into FMA
+enum class FPContract {
+  /// Every operation is rounded
+  Off,
+  /// A multiplication may be fused with the addition it is an operand of,
+  /// within an expression
+  On,
+  /// Any multiplication may be fused with any addition using its result
+  Fast,
+};
+
+/// Options controlling the lowering of a TranslationUnit
+struct Options final {
+  /// Names of the functions visible outside of the module, besides those
+  /// annotated @export. Other functions get internal linkage and the fast
+  /// calling convention. If empty and no function is annotated @export, every
+  /// function is exported
+  std::vector<std::string> Exports;
+  /// Whether to emit, for every function f, a companion f_grad also computing
+  /// the partial derivatives of f with respect to each of its parameters
+  bool Gradients{false};
+  /// Whether to emit a table of the exported functions, perfect-hashed by name,
+  /// and its accessor mua_lookup, so that hosts may call functions by name
+  bool DispatchTable{false};
+  FPModel FloatingPoint{FPModel::Precise};
+  /// Contraction is incompatible with the Strict model
+  FPContract Contraction{FPContract::Off};
+  /// Format of every number: parameters, variables, literals (rounded to
+  /// nearest) and results, including those of gradient companions
+  FPPrecision Precision{FPPrecision::F64};
+};
+
 /// Lower the given TranslationUnit into LLVM IR using the provided semantic
-/// information in Scope
-IRUnit LowerToLLVMIR(const ast::TranslationUnit &, const sema::Scope &);
+/// information in Scope. As functions have no side effects, every function is
+/// marked as not accessing memory, and those whose calls are known to return as
+/// speculatable
+IRUnit LowerToLLVMIR(const ast::TranslationUnit &, const sema::Scope &,
+                     const Options & = {});
+
+/// Optimization levels of the LLVM pass pipeline
+enum class OptLevel { O0, O1, O2, O3, Os };
+
+/// Run the default LLVM pass pipeline of the given level over the Module of an
+/// IRUnit. Only functions annotated @inline are inlined at O0, and loops and
+/// straight-line code are vectorized from O2. If a TargetMachine is provided,
+/// passes use its cost model
+void Optimize(IRUnit &, OptLevel, llvm::TargetMachine * = nullptr);
+
+/// Optimization level picked for a function to fit a compile-time budget
+struct FunctionOptLevel final {
+  std::string Name;
+  OptLevel Level;
+  /// Estimated time to optimize and generate code for the function at its
+  /// level, in milliseconds
+  double EstimatedMs;
+};
+
+/// Pick the O0, O1 or O3 pipeline of every function of a TranslationUnit, so
+/// that the estimated time to optimize and generate code for the module fits
+/// in the given budget, in milliseconds. Costs are estimated from the size of
+/// each function, including the small callees expected to be inlined into it.
+/// Functions are raised from O0 hot ones first, then in order of cost per
+/// caller. Levels are returned in source order
+std::vector<FunctionOptLevel> PlanOptLevels(const ast::TranslationUnit &,
+                                            const sema::Scope &, double);
+
+/// Run, over the Module of an IRUnit, the pipeline of each function's level.
+/// O0 functions are marked optnone, so that the code generator does not
+/// optimize them either. Functions without a level, such as gradient
+/// companions and the dispatch table, are only optimized by the pipeline of
+/// the lowest level above O0, if any. @inline is honored at every level
+void Optimize(IRUnit &, llvm::ArrayRef<FunctionOptLevel>,
+              llvm::TargetMachine * = nullptr);
+
+/// Report the level of every function, and the estimated total against the
+/// given budget, to the given output stream
+void ReportOptLevels(llvm::ArrayRef<FunctionOptLevel>, double,
+                     llvm::raw_ostream &);
 
 /// Dump the contents of an IRUnit (the generated LLVM IR) to the given output
 /// stream
 void Dump(const IRUnit &, llvm::raw_ostream &);
 
+/// Write the Module of an IRUnit as LLVM bitcode to the given output stream
+void WriteBitcode(const IRUnit &, llvm::raw_ostream &);
+
+/// Prepend the given prefix to the symbol of every global value defined in the
+/// Module of an IRUnit and visible outside of it, so that several modules can
+/// be linked together. Local symbols clashing with the new names are renamed
+void PrefixSymbols(IRUnit &, llvm::StringRef);
+
+/// Write a C header declaring every function exported by the Module of an
+/// IRUnit lowered from the given TranslationUnit, with the parameter names of
+/// its Scope, numbers of the given precision and the given symbol prefix, as
+/// well as their gradient companions and the accessor of the dispatch table.
+/// Must be called before PrefixSymbols. On failure, returns false and writes
+/// diagnostics to the provided output stream
+bool WriteHeader(const IRUnit &, const ast::TranslationUnit &,
+                 const sema::Scope &, FPPrecision, llvm::StringRef,
+                 llvm::raw_ostream &, llvm::raw_ostream &);
+
 } // namespace mua::lower
 
 #endif // MUA_LOWER_LOWER_H
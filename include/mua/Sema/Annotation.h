@@ -0,0 +1,71 @@
+// MIT License
+//
+// Copyright (c) 2026-onwards Iñaki Amatria-Barral
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef MUA_SEMA_ANNOTATION_H
+#define MUA_SEMA_ANNOTATION_H
+
+#include "llvm/ADT/StringRef.h"
+#include <optional>
+
+namespace mua::ast {
+struct FunctionDecl;
+} // namespace mua::ast
+
+namespace mua::sema {
+
+/// An annotation of a function declaration, spelled @name before the function
+/// keyword. Annotations only guide code generation: they never change what a
+/// function computes
+struct Annotation final {
+  enum class ID {
+    /// Always inline calls to the function
+    Inline,
+    /// Never inline calls to the function
+    NoInline,
+    /// The function is on a hot path: optimize it for speed and place it with
+    /// the other hot functions
+    Hot,
+    /// The function is rarely called: optimize it for size and place it away
+    /// from the hot functions
+    Cold,
+    /// The function is visible outside of the module
+    Export,
+  };
+
+  ID TheID;
+  llvm::StringLiteral Name;
+};
+
+/// Return the Annotation of the given name, or nullptr if there is none
+const Annotation *LookupAnnotation(llvm::StringRef);
+
+/// Return the Annotation that may not annotate the same function as the given
+/// one, if any
+std::optional<Annotation::ID> GetIncompatibleAnnotation(Annotation::ID);
+
+/// Return whether a FunctionDecl, which must have been analyzed, has the given
+/// Annotation
+bool HasAnnotation(const ast::FunctionDecl &, Annotation::ID);
+
+} // namespace mua::sema
+
+#endif // MUA_SEMA_ANNOTATION_H
@@ -0,0 +1,59 @@
+// MIT License
+//
+// Copyright (c) 2026-onwards Iñaki Amatria-Barral
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef MUA_SEMA_BUILTIN_H
+#define MUA_SEMA_BUILTIN_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
+
+namespace mua::sema {
+
+/// A function provided by the language rather than defined in the source. Every
+/// Builtin is declared in a Scope enclosing the global Scope, so its name may
+/// not be used for anything else
+struct Builtin final {
+  enum class ID {
+    Sqrt,
+    Exp,
+    Log,
+    Pow,
+    Fma,
+    Min,
+    Max,
+    Abs,
+  };
+
+  ID TheID;
+  llvm::StringLiteral Name;
+  unsigned Arity;
+};
+
+/// Return every Builtin
+llvm::ArrayRef<Builtin> GetBuiltins();
+
+/// Return the Builtin of the given name, or nullptr if there is none
+const Builtin *LookupBuiltin(llvm::StringRef);
+
+} // namespace mua::sema
+
+#endif // MUA_SEMA_BUILTIN_H
@@ -0,0 +1,75 @@
+// MIT License
+//
+// Copyright (c) 2026-onwards Iñaki Amatria-Barral
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef MUA_SEMA_CALLGRAPH_H
+#define MUA_SEMA_CALLGRAPH_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include <vector>
+
+namespace mua::ast {
+struct TranslationUnit;
+} // namespace mua::ast
+
+namespace mua::sema {
+
+struct Scope;
+struct Symbol;
+
+/// Call graph of an analyzed TranslationUnit, with the properties of each
+/// function that follow from it
+struct CallGraph final {
+  /// Build the CallGraph of a TranslationUnit from its global Scope
+  CallGraph(const ast::TranslationUnit &, const Scope &);
+
+  /// Functions called by the given function, in order of first call. Builtins
+  /// are not included
+  llvm::ArrayRef<const Symbol *> getCallees(const Symbol *function) const {
+    auto it{Callees.find(function)};
+    return it == Callees.end() ? llvm::ArrayRef<const Symbol *>{}
+                               : llvm::ArrayRef<const Symbol *>{it->second};
+  }
+
+  /// Whether the function may call itself, directly or through other functions
+  bool isRecursive(const Symbol *function) const {
+    return Recursive.contains(function);
+  }
+
+  /// Whether every call of the function returns. Loops run a number of times
+  /// fixed on entry, so only functions that cannot reach a recursive function
+  /// are known to return: recursion may or may not stop at a conditional
+  /// expression
+  bool isTerminating(const Symbol *function) const {
+    return Terminating.contains(function);
+  }
+
+private:
+  llvm::DenseMap<const Symbol *, std::vector<const Symbol *>> Callees;
+  llvm::DenseSet<const Symbol *> Recursive;
+  llvm::DenseSet<const Symbol *> Terminating;
+};
+
+} // namespace mua::sema
+
+#endif // MUA_SEMA_CALLGRAPH_H
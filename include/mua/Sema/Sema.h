@@ -23,25 +23,57 @@
 #ifndef MUA_SEMA_SEMA_H
 #define MUA_SEMA_SEMA_H
 
+#include "llvm/ADT/StringRef.h"
 #include <memory>
+#include <vector>
 
 namespace llvm {
 class raw_ostream;
 } // namespace llvm
 
 namespace mua::ast {
+struct ForStmt;
 struct TranslationUnit;
 } // namespace mua::ast
 
 namespace mua::sema {
 
 struct Scope;
+struct Symbol;
 
-/// Perform semantic analysis on a full TranslationUnit. On error, returns
-/// nullptr and reports diagnostics to the provided output stream
+/// Perform semantic analysis on a full TranslationUnit. Every function
+/// signature is declared before any body is analyzed, so functions may be
+/// called before their definition, and bodies are analyzed in parallel. On
+/// error, returns nullptr and reports diagnostics to the provided output stream
+/// in source order
 std::unique_ptr<Scope> Analyze(const ast::TranslationUnit &,
                                llvm::raw_ostream &);
 
+/// Report performance warnings (-Wperf) about correct but slow code, such as
+/// repeated divisions or calls, to the given output stream
+void Lint(const ast::TranslationUnit &, const Scope &, llvm::raw_ostream &);
+
+/// Return the variables assigned in the body of a for loop, including the
+/// variables of nested loops, in source order. The Scope is the one of the
+/// enclosing function
+std::vector<const Symbol *> GetAssignedVars(const ast::ForStmt &,
+                                            const Scope &);
+
+/// Suffix naming the gradient companion of a function
+inline constexpr llvm::StringLiteral GradientSuffix{"_grad"};
+
+/// Check that the gradient companion of every function can be named, that is
+/// that no function is named like the companion of another one. On error,
+/// returns false and reports diagnostics to the provided output stream
+bool CheckGradients(const Scope &, llvm::raw_ostream &);
+
+/// Name of the accessor of the dispatch table of exported functions
+inline constexpr llvm::StringLiteral DispatchAccessor{"mua_lookup"};
+
+/// Check that no function is named like the accessor of the dispatch table. On
+/// error, returns false and reports diagnostics to the provided output stream
+bool CheckDispatchTable(const Scope &, llvm::raw_ostream &);
+
 /// Dump the semantic information to the given output stream
 void Dump(const Scope &, llvm::raw_ostream &);
 
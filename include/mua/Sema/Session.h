@@ -0,0 +1,82 @@
+// MIT License
+//
+// Copyright (c) 2026-onwards Iñaki Amatria-Barral
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef MUA_SEMA_SESSION_H
+#define MUA_SEMA_SESSION_H
+
+#include "mua/Source/Position.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringMap.h"
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace mua::ast {
+struct TranslationUnit;
+} // namespace mua::ast
+
+namespace mua::sema {
+
+struct Scope;
+
+/// Incremental semantic analysis over successive versions of a
+/// TranslationUnit, e.g. after every edit in watch mode. Signatures are always
+/// declared again, but a function body is only re-analyzed when its source
+/// text changed or when a global name it refers to changed meaning (a callee
+/// was added, removed or got a different number of parameters). Otherwise, the
+/// function Scope built by the previous analysis is reused as is
+struct Session final {
+  Session();
+  ~Session();
+
+  /// Analyze a new version of the TranslationUnit. On error, returns nullptr,
+  /// reports diagnostics to the provided output stream and forgets every
+  /// previous result. The returned Scope is owned by the Session and stays
+  /// valid until the next call
+  const Scope *analyze(const ast::TranslationUnit &, llvm::raw_ostream &);
+
+  /// Names of the functions whose bodies were analyzed by the last call, in
+  /// source order
+  llvm::ArrayRef<std::string> getAnalyzed() const { return Analyzed; }
+
+private:
+  /// What the analysis of a single function depended on
+  struct Entry final {
+    /// Source text of the FunctionDecl
+    std::string Text;
+    /// Offset of the FunctionDecl in its File
+    source::Offset Begin;
+    /// Global names referred to by the body, mapped to the number of
+    /// parameters of the function they named (std::nullopt if none)
+    llvm::StringMap<std::optional<unsigned>> Dependencies;
+  };
+
+  std::unique_ptr<Scope> GlobalScope;
+  llvm::StringMap<Entry> Entries;
+  std::vector<std::string> Analyzed;
+};
+
+} // namespace mua::sema
+
+#endif // MUA_SEMA_SESSION_H
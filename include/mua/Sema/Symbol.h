@@ -38,6 +38,7 @@ struct Symbol final {
     Param,
     Function,
     Var,
+    Builtin,
   };
 
   Symbol(Kind kind, source::Text name)
@@ -50,6 +51,12 @@ struct Symbol final {
   const Scope *getScope() const { return TheScope.get(); }
 
   void setScope(std::unique_ptr<Scope> scope) { TheScope = std::move(scope); }
+  std::unique_ptr<Scope> takeScope() { return std::move(TheScope); }
+
+  /// Move the Symbol (and its Scope, if any) into the given File, shifting its
+  /// position by the given number of bytes. Used to reuse Symbols whose source
+  /// text is unchanged but has moved
+  void relocate(const source::File &, std::int64_t);
 
 private:
   Kind TheKind;
@@ -77,18 +84,19 @@ struct Scope final {
       break;
     case Symbol::Kind::Param:
     case Symbol::Kind::Var:
+    case Symbol::Kind::Builtin:
       break;
     }
     return {symbol, true};
   }
 
   /// Lookup recursively in parent Scopes
-  Symbol *lookup(source::Text name) {
+  Symbol *lookup(llvm::StringRef name) {
     return const_cast<Symbol *>(static_cast<const Scope *>(this)->lookup(name));
   }
 
   /// Lookup recursively in parent Scopes
-  const Symbol *lookup(source::Text name) const {
+  const Symbol *lookup(llvm::StringRef name) const {
     for (const Scope *scope{this}; scope; scope = scope->Parent) {
       if (auto it{scope->Symbols.find(name)}; it != scope->Symbols.end()) {
         return &it->second;
@@ -113,6 +121,19 @@ struct Scope final {
     return symbols;
   }
 
+  /// Attach this Scope to a new parent Scope and owning Symbol
+  void reattach(Scope *parent, Symbol *symbol) {
+    Parent = parent;
+    TheSymbol = symbol;
+  }
+
+  /// Relocate every Symbol declared in this Scope (see Symbol::relocate)
+  void relocate(const source::File &file, std::int64_t delta) {
+    for (auto &pair : Symbols) {
+      pair.second.relocate(file, delta);
+    }
+  }
+
   Scope *getParent() { return Parent; }
   const Scope *getParent() const { return Parent; }
 
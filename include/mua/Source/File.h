@@ -42,6 +42,10 @@ public:
   /// output stream
   static std::unique_ptr<File> Open(llvm::StringRef, llvm::raw_ostream &);
 
+  /// Create a File with the given name over text held in memory, which must
+  /// outlive the File
+  static std::unique_ptr<File> Create(llvm::StringRef, llvm::StringRef);
+
   /// Access the underlying buffer
   llvm::MemoryBufferRef getBuffer() const;
 
@@ -0,0 +1,66 @@
+// MIT License
+//
+// Copyright (c) 2026-onwards Iñaki Amatria-Barral
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#ifndef MUA_SUPPORT_FPPRECISION_H
+#define MUA_SUPPORT_FPPRECISION_H
+
+#include "mua/Support/ErrorHandling.h"
+#include "llvm/ADT/APFloat.h"
+
+namespace mua {
+
+/// Floating-point formats that numbers may be computed in
+enum class FPPrecision {
+  /// IEEE 754 binary32, as float
+  F32,
+  /// IEEE 754 binary64, as double
+  F64,
+};
+
+/// Semantics of the floating-point format of a precision
+inline const llvm::fltSemantics &GetSemantics(FPPrecision precision) {
+  switch (precision) {
+  case FPPrecision::F32:
+    return llvm::APFloat::IEEEsingle();
+  case FPPrecision::F64:
+    return llvm::APFloat::IEEEdouble();
+  }
+  MUA_COVERS_ALL_CASES;
+}
+
+/// Round a value to nearest (ties to even) in the format of a precision.
+/// Values beyond its largest finite number become infinite
+inline llvm::APFloat ToAPFloat(double value, FPPrecision precision) {
+  llvm::APFloat result{value};
+  bool losesInfo;
+  result.convert(GetSemantics(precision), llvm::APFloat::rmNearestTiesToEven,
+                 &losesInfo);
+  return result;
+}
+
+/// Round a value as ToAPFloat does, back as a double (which is exact)
+inline double Round(double value, FPPrecision precision) {
+  return ToAPFloat(value, precision).convertToDouble();
+}
+
+} // namespace mua
+
+#endif // MUA_SUPPORT_FPPRECISION_H
@@ -0,0 +1,48 @@
+// MIT License
+//
+// Copyright (c) 2026-onwards Iñaki Amatria-Barral
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef MUA_TRANSFORM_CONSTEVAL_H
+#define MUA_TRANSFORM_CONSTEVAL_H
+
+#include "mua/Support/FPPrecision.h"
+#include <memory>
+
+namespace mua::ast {
+struct TranslationUnit;
+} // namespace mua::ast
+
+namespace mua::transform {
+
+/// Evaluate at compile time every call whose arguments are all numeric
+/// literals, and replace it by a NumberExpr holding its value. Evaluation uses
+/// IEEE 754 arithmetic of the given precision rounding to nearest, as the
+/// lowered code does, so results are bit-identical. Calls that exceed the step
+/// budget, read an uninitialized variable, produce a NaN or need a Builtin not
+/// exactly specified by IEEE 754 are kept as they are. The TranslationUnit must
+/// be semantically valid
+std::unique_ptr<ast::TranslationUnit>
+EvaluateConstantCalls(const ast::TranslationUnit &,
+                      FPPrecision = FPPrecision::F64);
+
+} // namespace mua::transform
+
+#endif // MUA_TRANSFORM_CONSTEVAL_H
@@ -0,0 +1,61 @@
+// MIT License
+//
+// Copyright (c) 2026-onwards Iñaki Amatria-Barral
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef MUA_TRANSFORM_REWRITE_H
+#define MUA_TRANSFORM_REWRITE_H
+
+#include "mua/Support/FPPrecision.h"
+#include <memory>
+
+namespace mua::ast {
+struct TranslationUnit;
+} // namespace mua::ast
+
+namespace mua::sema {
+struct Scope;
+} // namespace mua::sema
+
+namespace mua::transform {
+
+/// Floating-point semantics that algebraic rewrites must preserve
+enum class RewritePolicy {
+  /// Only rewrites giving bit-identical results for every input
+  Strict,
+  /// Also rewrites that are exact in real arithmetic but may round differently
+  /// or change the sign of zero: reassociation, reciprocals, factoring
+  Fast,
+};
+
+/// Rewrite numeric Expressions for speed: division by a constant as
+/// multiplication by its reciprocal, sums of quotients with a common
+/// denominator as a single quotient, polynomials in Horner (or, from degree 4,
+/// Estrin) form, and long sums and products as balanced trees. Rewrites are
+/// described by a table and applied bottom-up, each only if allowed by the
+/// policy. Constants are computed with the given precision. Powers shared by
+/// Estrin form are held by variables declared in the Scope of their function
+std::unique_ptr<ast::TranslationUnit>
+Rewrite(const ast::TranslationUnit &, sema::Scope &, RewritePolicy,
+        FPPrecision = FPPrecision::F64);
+
+} // namespace mua::transform
+
+#endif // MUA_TRANSFORM_REWRITE_H
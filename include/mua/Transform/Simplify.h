@@ -0,0 +1,50 @@
+// MIT License
+//
+// Copyright (c) 2026-onwards Iñaki Amatria-Barral
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef MUA_TRANSFORM_SIMPLIFY_H
+#define MUA_TRANSFORM_SIMPLIFY_H
+
+#include "mua/Support/FPPrecision.h"
+#include <memory>
+
+namespace mua::ast {
+struct TranslationUnit;
+} // namespace mua::ast
+
+namespace mua::sema {
+struct Scope;
+} // namespace mua::sema
+
+namespace mua::transform {
+
+/// Simplify every function body without changing its results: constant folding
+/// and propagation, exact identities (x * 1, x / 1, x - 0), copy propagation,
+/// reuse of values already held by a variable, and removal of dead assignments.
+/// Constants are rounded to, and folded with, the given precision. Runs in time
+/// linear in the size of the TranslationUnit
+std::unique_ptr<ast::TranslationUnit>
+Simplify(const ast::TranslationUnit &, const sema::Scope &,
+         FPPrecision = FPPrecision::F64);
+
+} // namespace mua::transform
+
+#endif // MUA_TRANSFORM_SIMPLIFY_H
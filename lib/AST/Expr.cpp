@@ -28,6 +28,25 @@
 using namespace mua;
 using namespace mua::ast;
 
+bool mua::ast::IsComparison(BinaryExpr::Op op) {
+  switch (op) {
+  case BinaryExpr::Op::Assign:
+  case BinaryExpr::Op::Add:
+  case BinaryExpr::Op::Sub:
+  case BinaryExpr::Op::Mul:
+  case BinaryExpr::Op::Div:
+    return false;
+  case BinaryExpr::Op::Less:
+  case BinaryExpr::Op::LessEqual:
+  case BinaryExpr::Op::Greater:
+  case BinaryExpr::Op::GreaterEqual:
+  case BinaryExpr::Op::Equal:
+  case BinaryExpr::Op::NotEqual:
+    return true;
+  }
+  MUA_COVERS_ALL_CASES;
+}
+
 llvm::raw_ostream &mua::ast::operator<<(llvm::raw_ostream &os,
                                         BinaryExpr::Op op) {
   switch (op) {
@@ -41,6 +60,18 @@ llvm::raw_ostream &mua::ast::operator<<(llvm::raw_ostream &os,
     return os << '*';
   case BinaryExpr::Op::Div:
     return os << '/';
+  case BinaryExpr::Op::Less:
+    return os << '<';
+  case BinaryExpr::Op::LessEqual:
+    return os << "<=";
+  case BinaryExpr::Op::Greater:
+    return os << '>';
+  case BinaryExpr::Op::GreaterEqual:
+    return os << ">=";
+  case BinaryExpr::Op::Equal:
+    return os << "==";
+  case BinaryExpr::Op::NotEqual:
+    return os << "~=";
   }
   MUA_COVERS_ALL_CASES;
 }
@@ -66,6 +66,15 @@ struct DumpVisitor final {
 
   void onExit(const BinaryExpr &) { --Level; }
 
+  bool onEnter(const ConditionalExpr &cond) {
+    printIndent();
+    OS << "ConditionalExpr [" << cond.getRange() << "]\n";
+    ++Level;
+    return true;
+  }
+
+  void onExit(const ConditionalExpr &) { --Level; }
+
   bool onEnter(const ExprStmt &es) {
     printIndent();
     OS << "ExprStmt [" << es.getRange() << "]\n";
@@ -93,6 +102,15 @@ struct DumpVisitor final {
 
   void onExit(const CompoundStmt &) { --Level; }
 
+  bool onEnter(const ForStmt &fs) {
+    printIndent();
+    OS << "ForStmt " << fs.getVar() << " [" << fs.getRange() << "]\n";
+    ++Level;
+    return true;
+  }
+
+  void onExit(const ForStmt &) { --Level; }
+
   bool onEnter(const ParamDecl &pd) {
     printIndent();
     OS << "ParamDecl " << pd.getName() << " [" << pd.getRange() << "]\n";
@@ -101,7 +119,11 @@ struct DumpVisitor final {
 
   bool onEnter(const FunctionDecl &fn) {
     printIndent();
-    OS << "FunctionDecl " << fn.getName() << " [" << fn.getRange() << "]\n";
+    OS << "FunctionDecl " << fn.getName();
+    for (source::Text annotation : fn.getAnnotations()) {
+      OS << " @" << annotation;
+    }
+    OS << " [" << fn.getRange() << "]\n";
     ++Level;
     return true;
   }
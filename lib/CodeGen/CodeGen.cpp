@@ -0,0 +1,184 @@
+// MIT License
+//
+// Copyright (c) 2026-onwards Iñaki Amatria-Barral
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "mua/CodeGen/CodeGen.h"
+
+#include "EmitFile.h"
+#include "mua/Lower/IRUnit.h"
+#include "mua/Support/ErrorHandling.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/MC/MCSubtargetInfo.h"
+#include "llvm/MC/TargetRegistry.h"
+#include "llvm/Object/ArchiveWriter.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetMachine.h"
+#include "llvm/TargetParser/Host.h"
+#include "llvm/TargetParser/SubtargetFeature.h"
+#include "llvm/TargetParser/Triple.h"
+
+using namespace mua;
+using namespace mua::codegen;
+
+static llvm::CodeGenOptLevel GetCodeGenOptLevel(lower::OptLevel level) {
+  switch (level) {
+  case lower::OptLevel::O0:
+    return llvm::CodeGenOptLevel::None;
+  case lower::OptLevel::O1:
+    return llvm::CodeGenOptLevel::Less;
+  case lower::OptLevel::O2:
+  case lower::OptLevel::Os:
+    return llvm::CodeGenOptLevel::Default;
+  case lower::OptLevel::O3:
+    return llvm::CodeGenOptLevel::Aggressive;
+  }
+  MUA_COVERS_ALL_CASES;
+}
+
+std::unique_ptr<llvm::TargetMachine>
+mua::codegen::CreateTargetMachine(const TargetOptions &options,
+                                  llvm::raw_ostream &os) {
+  // Any registered target may be selected, so register them all once
+  static const bool initialized{[] {
+    llvm::InitializeAllTargetInfos();
+    llvm::InitializeAllTargets();
+    llvm::InitializeAllTargetMCs();
+    llvm::InitializeAllAsmPrinters();
+    return true;
+  }()};
+  (void)initialized;
+
+  std::string triple{options.Triple.empty()
+                         ? llvm::sys::getDefaultTargetTriple()
+                         : options.Triple};
+  std::string error;
+  const llvm::Target *target{llvm::TargetRegistry::lookupTarget(triple, error)};
+  if (!target) {
+    os << "error: unsupported target triple " << triple << ": " << error
+       << '\n';
+    return nullptr;
+  }
+
+  std::string cpu{options.CPU};
+  std::string features;
+  if (cpu == "native") {
+    cpu = llvm::sys::getHostCPUName().str();
+    llvm::SubtargetFeatures subtargetFeatures;
+    for (const llvm::StringMapEntry<bool> &feature :
+         llvm::sys::getHostCPUFeatures()) {
+      subtargetFeatures.AddFeature(feature.getKey(), feature.getValue());
+    }
+    features = subtargetFeatures.getString();
+  }
+  std::unique_ptr<llvm::TargetMachine> targetMachine{
+      target->createTargetMachine(triple, cpu, features, llvm::TargetOptions{},
+                                  options.RelocModel, /*CM=*/std::nullopt,
+                                  GetCodeGenOptLevel(options.Level))};
+  if (!targetMachine->getMCSubtargetInfo()->isCPUStringValid(cpu)) {
+    os << "error: unknown target CPU " << cpu << '\n';
+    return nullptr;
+  }
+  return targetMachine;
+}
+
+void mua::codegen::SetTarget(lower::IRUnit &theIRUnit,
+                             const llvm::TargetMachine &targetMachine) {
+  theIRUnit.Module->setTargetTriple(targetMachine.getTargetTriple().str());
+  theIRUnit.Module->setDataLayout(targetMachine.createDataLayout());
+  // Record the target in every function, as do C compilers, so that functions
+  // specialized for other CPUs can be told apart
+  for (llvm::Function &function : *theIRUnit.Module) {
+    function.addFnAttr("target-cpu", targetMachine.getTargetCPU());
+    if (!targetMachine.getTargetFeatureString().empty()) {
+      function.addFnAttr("target-features",
+                         targetMachine.getTargetFeatureString());
+    }
+  }
+}
+
+bool mua::codegen::EmitFile(lower::IRUnit &theIRUnit,
+                            llvm::TargetMachine &targetMachine, FileKind kind,
+                            llvm::raw_pwrite_stream &os,
+                            llvm::raw_ostream &errs) {
+  llvm::CodeGenFileType fileType{kind == FileKind::Object
+                                     ? llvm::CodeGenFileType::ObjectFile
+                                     : llvm::CodeGenFileType::AssemblyFile};
+  llvm::legacy::PassManager passManager;
+  if (targetMachine.addPassesToEmitFile(passManager, os, /*DwoOut=*/nullptr,
+                                        fileType)) {
+    errs << "error: target " << targetMachine.getTargetTriple().str()
+         << " cannot emit this kind of file\n";
+    return false;
+  }
+  passManager.run(*theIRUnit.Module);
+  return true;
+}
+
+bool mua::codegen::Emit(lower::IRUnit &theIRUnit,
+                        llvm::TargetMachine &targetMachine, FileKind kind,
+                        llvm::raw_fd_ostream &os, llvm::raw_ostream &errs) {
+  // Object writers seek back to patch headers, which pipes do not support
+  if (!os.supportsSeeking()) {
+    llvm::buffer_ostream buffer{os};
+    return EmitFile(theIRUnit, targetMachine, kind, buffer, errs);
+  }
+  return EmitFile(theIRUnit, targetMachine, kind, os, errs);
+}
+
+bool mua::codegen::WriteArchive(llvm::ArrayRef<llvm::NewArchiveMember> members,
+                                const llvm::Triple &triple,
+                                llvm::raw_ostream &os,
+                                llvm::raw_ostream &errs) {
+  llvm::Expected<std::unique_ptr<llvm::MemoryBuffer>> archive{
+      llvm::writeArchiveToBuffer(
+          members, llvm::SymtabWritingMode::NormalSymtab,
+          llvm::object::Archive::getDefaultKindForTriple(triple),
+          /*Deterministic=*/true, /*Thin=*/false)};
+  if (!archive) {
+    errs << "error: could not write archive: "
+         << llvm::toString(archive.takeError()) << '\n';
+    return false;
+  }
+  os << (*archive)->getBuffer();
+  return true;
+}
+
+bool mua::codegen::EmitLibrary(lower::IRUnit &theIRUnit,
+                               llvm::TargetMachine &targetMachine,
+                               llvm::raw_fd_ostream &os,
+                               llvm::raw_ostream &errs) {
+  llvm::SmallVector<char, 0> object;
+  llvm::raw_svector_ostream objectStream{object};
+  if (!EmitFile(theIRUnit, targetMachine, FileKind::Object, objectStream,
+                errs)) {
+    return false;
+  }
+  // Name the member after the source file, as a C compiler would
+  std::string name{
+      (llvm::sys::path::stem(theIRUnit.Module->getSourceFileName()) + ".o")
+          .str()};
+  llvm::NewArchiveMember member{llvm::MemoryBufferRef{
+      llvm::StringRef{object.data(), object.size()}, name}};
+  return WriteArchive(member, llvm::Triple{theIRUnit.Module->getTargetTriple()},
+                      os, errs);
+}
@@ -0,0 +1,339 @@
+// MIT License
+//
+// Copyright (c) 2026-onwards Iñaki Amatria-Barral
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "mua/CodeGen/CodeGen.h"
+
+#include "mua/Lower/IRUnit.h"
+#include "mua/Support/ErrorHandling.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetMachine.h"
+#include <algorithm>
+#include <array>
+#include <iterator>
+
+using namespace mua;
+using namespace mua::codegen;
+
+namespace {
+
+/// Names of the metrics of a report, in column order
+constexpr llvm::StringLiteral Metrics[]{"instructions", "throughput",
+                                        "latency", "calls"};
+
+using MetricValues = std::array<std::int64_t, std::size(Metrics)>;
+
+MetricValues getMetrics(const FunctionCost &cost) {
+  return {cost.Instructions, cost.Throughput, cost.Latency, cost.Calls};
+}
+
+std::int64_t getValue(llvm::InstructionCost cost) {
+  return cost.isValid() ? cost.getValue() : 0;
+}
+
+/// Latency of the longest chain of dependent instructions of a function.
+/// Blocks are visited in reverse post-order, so the operands of every
+/// instruction are ready before it, except for values carried around loops,
+/// which are ignored
+std::int64_t estimateLatency(const llvm::Function &function,
+                             const llvm::TargetTransformInfo &tti) {
+  llvm::DenseMap<const llvm::Instruction *, std::int64_t> ready;
+  std::int64_t latency{0};
+  for (const llvm::BasicBlock *block :
+       llvm::ReversePostOrderTraversal<const llvm::Function *>{&function}) {
+    for (const llvm::Instruction &instruction : *block) {
+      std::int64_t start{0};
+      for (const llvm::Value *operand : instruction.operand_values()) {
+        if (auto it{ready.find(llvm::dyn_cast<llvm::Instruction>(operand))};
+            it != ready.end()) {
+          start = std::max(start, it->second);
+        }
+      }
+      std::int64_t end{
+          start + getValue(tti.getInstructionCost(
+                      &instruction, llvm::TargetTransformInfo::TCK_Latency))};
+      ready[&instruction] = end;
+      latency = std::max(latency, end);
+    }
+  }
+  return latency;
+}
+
+/// A function of a report, with its costs in the report and in the baseline
+/// of the report, if any. Functions only in the baseline cost nothing
+struct Row final {
+  llvm::StringRef Name;
+  MetricValues Values;
+  std::optional<MetricValues> Baseline;
+  /// Whether the function is only in the baseline
+  bool Removed;
+};
+
+std::vector<Row> getRows(llvm::ArrayRef<FunctionCost> costs,
+                         const std::vector<FunctionCost> *baseline) {
+  auto find{[](llvm::ArrayRef<FunctionCost> report,
+               llvm::StringRef name) -> const FunctionCost * {
+    auto it{llvm::find_if(
+        report, [&](const FunctionCost &cost) { return cost.Name == name; })};
+    return it == report.end() ? nullptr : it;
+  }};
+  std::vector<Row> rows;
+  for (const FunctionCost &cost : costs) {
+    Row row{cost.Name, getMetrics(cost), std::nullopt, /*Removed=*/false};
+    if (baseline) {
+      if (const FunctionCost *previous{find(*baseline, cost.Name)}) {
+        row.Baseline = getMetrics(*previous);
+      }
+    }
+    rows.push_back(row);
+  }
+  if (baseline) {
+    for (const FunctionCost &cost : *baseline) {
+      if (!find(costs, cost.Name)) {
+        rows.push_back({cost.Name, {}, getMetrics(cost), /*Removed=*/true});
+      }
+    }
+  }
+  return rows;
+}
+
+/// Write a table with one line per function and a line of totals. When
+/// diffing, every value is followed by its change, and new and removed
+/// functions are marked as such
+void writeText(llvm::ArrayRef<Row> rows, bool diff, llvm::raw_ostream &os) {
+  auto getCell{[&](std::int64_t value, std::int64_t baseline) {
+    std::string cell{std::to_string(value)};
+    if (diff && value != baseline) {
+      cell += (value > baseline ? " (+" : " (") +
+              std::to_string(value - baseline) + ')';
+    }
+    return cell;
+  }};
+  std::vector<std::vector<std::string>> lines{{"function"}};
+  for (llvm::StringRef metric : Metrics) {
+    lines.back().push_back(metric.str());
+  }
+  MetricValues total{};
+  MetricValues baselineTotal{};
+  for (const Row &row : rows) {
+    std::vector<std::string> &line{lines.emplace_back()};
+    line.push_back(row.Name.str());
+    for (std::size_t i{0}; i < total.size(); ++i) {
+      std::int64_t baseline{row.Baseline ? (*row.Baseline)[i] : 0};
+      line.push_back(getCell(row.Values[i], baseline));
+      total[i] += row.Values[i];
+      baselineTotal[i] += baseline;
+    }
+    if (row.Removed) {
+      line.push_back("removed");
+    } else if (diff && !row.Baseline) {
+      line.push_back("new");
+    }
+  }
+  std::vector<std::string> &totalLine{lines.emplace_back()};
+  totalLine.push_back("total");
+  for (std::size_t i{0}; i < total.size(); ++i) {
+    totalLine.push_back(getCell(total[i], baselineTotal[i]));
+  }
+
+  std::vector<std::size_t> widths(1 + total.size());
+  for (const std::vector<std::string> &line : lines) {
+    for (std::size_t i{0}; i < widths.size(); ++i) {
+      widths[i] = std::max(widths[i], line[i].size());
+    }
+  }
+  for (const std::vector<std::string> &line : lines) {
+    // Names are aligned left and values right
+    os << llvm::left_justify(line[0], widths[0]);
+    for (std::size_t i{1}; i < widths.size(); ++i) {
+      os << "  " << llvm::right_justify(line[i], widths[i]);
+    }
+    if (line.size() > widths.size()) {
+      os << "  " << line.back();
+    }
+    os << '\n';
+  }
+}
+
+void writeMetrics(llvm::json::OStream &json, const MetricValues &values) {
+  for (auto [metric, value] : llvm::zip_equal(Metrics, values)) {
+    json.attribute(metric, value);
+  }
+}
+
+/// Write an object holding the array of functions with their costs. When
+/// diffing, every function also holds its baseline costs, or null if it is
+/// new, and functions only in the baseline are in a second array
+void writeJSON(llvm::ArrayRef<Row> rows, bool diff, llvm::raw_ostream &os) {
+  llvm::json::OStream json{os, /*IndentSize=*/2};
+  json.object([&] {
+    json.attributeArray("functions", [&] {
+      for (const Row &row : rows) {
+        if (row.Removed) {
+          continue;
+        }
+        json.object([&] {
+          json.attribute("name", row.Name);
+          writeMetrics(json, row.Values);
+          if (!diff) {
+            return;
+          }
+          json.attributeBegin("baseline");
+          if (row.Baseline) {
+            json.object([&] { writeMetrics(json, *row.Baseline); });
+          } else {
+            json.value(nullptr);
+          }
+          json.attributeEnd();
+        });
+      }
+    });
+    if (!diff) {
+      return;
+    }
+    json.attributeArray("removed", [&] {
+      for (const Row &row : rows) {
+        if (row.Removed) {
+          json.object([&] {
+            json.attribute("name", row.Name);
+            writeMetrics(json, *row.Baseline);
+          });
+        }
+      }
+    });
+  });
+  os << '\n';
+}
+
+/// Read the costs of a function of a report
+std::optional<FunctionCost>
+readFunctionCost(const llvm::json::Value &function) {
+  const llvm::json::Object *object{function.getAsObject()};
+  if (!object) {
+    return std::nullopt;
+  }
+  std::optional<llvm::StringRef> name{object->getString("name")};
+  if (!name) {
+    return std::nullopt;
+  }
+  MetricValues values;
+  for (auto [metric, value] : llvm::zip_equal(Metrics, values)) {
+    std::optional<std::int64_t> integer{object->getInteger(metric)};
+    if (!integer) {
+      return std::nullopt;
+    }
+    value = *integer;
+  }
+  return FunctionCost{name->str(), values[0], values[1], values[2],
+                      values[3]};
+}
+
+} // namespace
+
+std::vector<FunctionCost>
+mua::codegen::EstimateCosts(const lower::IRUnit &theIRUnit,
+                            llvm::TargetMachine &targetMachine) {
+  std::vector<FunctionCost> costs;
+  for (const llvm::Function &function : *theIRUnit.Module) {
+    if (function.isDeclaration()) {
+      continue;
+    }
+    llvm::TargetTransformInfo tti{
+        targetMachine.getTargetTransformInfo(function)};
+    FunctionCost cost{function.getName().str(),
+                      function.getInstructionCount(), /*Throughput=*/0,
+                      estimateLatency(function, tti), /*Calls=*/0};
+    for (const llvm::Instruction &instruction : llvm::instructions(function)) {
+      cost.Throughput += getValue(tti.getInstructionCost(
+          &instruction, llvm::TargetTransformInfo::TCK_RecipThroughput));
+      if (llvm::isa<llvm::CallBase>(instruction) &&
+          !llvm::isa<llvm::IntrinsicInst>(instruction)) {
+        ++cost.Calls;
+      }
+    }
+    costs.push_back(std::move(cost));
+  }
+  return costs;
+}
+
+void mua::codegen::WriteCostReport(llvm::ArrayRef<FunctionCost> costs,
+                                   const std::vector<FunctionCost> *baseline,
+                                   CostFormat format, llvm::raw_ostream &os) {
+  std::vector<Row> rows{getRows(costs, baseline)};
+  switch (format) {
+  case CostFormat::Text:
+    writeText(rows, baseline != nullptr, os);
+    return;
+  case CostFormat::JSON:
+    writeJSON(rows, baseline != nullptr, os);
+    return;
+  }
+  MUA_COVERS_ALL_CASES;
+}
+
+std::optional<std::vector<FunctionCost>>
+mua::codegen::ReadCostReport(llvm::StringRef filename, llvm::raw_ostream &os) {
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer{
+      llvm::MemoryBuffer::getFile(filename, /*IsText=*/true)};
+  if (!buffer) {
+    os << "error: could not open file " << filename << ": "
+       << buffer.getError().message() << '\n';
+    return std::nullopt;
+  }
+  llvm::Expected<llvm::json::Value> report{
+      llvm::json::parse((*buffer)->getBuffer())};
+  if (!report) {
+    os << "error: " << filename << ": " << llvm::toString(report.takeError())
+       << '\n';
+    return std::nullopt;
+  }
+
+  auto invalid{[&]() {
+    os << "error: " << filename << " is not a cost report\n";
+    return std::nullopt;
+  }};
+  const llvm::json::Object *object{report->getAsObject()};
+  const llvm::json::Array *functions{object ? object->getArray("functions")
+                                            : nullptr};
+  if (!functions) {
+    return invalid();
+  }
+  std::vector<FunctionCost> costs;
+  for (const llvm::json::Value &function : *functions) {
+    std::optional<FunctionCost> cost{readFunctionCost(function)};
+    if (!cost) {
+      return invalid();
+    }
+    costs.push_back(std::move(*cost));
+  }
+  return costs;
+}
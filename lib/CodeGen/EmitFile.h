@@ -0,0 +1,56 @@
+// MIT License
+//
+// Copyright (c) 2026-onwards Iñaki Amatria-Barral
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#ifndef MUA_LIB_CODEGEN_EMITFILE_H
+#define MUA_LIB_CODEGEN_EMITFILE_H
+
+#include "mua/CodeGen/CodeGen.h"
+
+namespace llvm {
+struct NewArchiveMember;
+class TargetMachine;
+class Triple;
+class raw_ostream;
+class raw_pwrite_stream;
+} // namespace llvm
+
+namespace mua::lower {
+struct IRUnit;
+} // namespace mua::lower
+
+namespace mua::codegen {
+
+/// Generate native code for the Module of an IRUnit and write it to the given
+/// seekable output stream. On failure, returns false and writes diagnostics to
+/// the provided output stream
+bool EmitFile(lower::IRUnit &, llvm::TargetMachine &, FileKind,
+              llvm::raw_pwrite_stream &, llvm::raw_ostream &);
+
+/// Write the given members to the given output stream as a static archive of
+/// the kind native to the target triple. Archives are deterministic: they zero
+/// timestamps and owners, so that they only depend on their members. On
+/// failure, returns false and writes diagnostics to the provided output stream
+bool WriteArchive(llvm::ArrayRef<llvm::NewArchiveMember>, const llvm::Triple &,
+                  llvm::raw_ostream &, llvm::raw_ostream &);
+
+} // namespace mua::codegen
+
+#endif // MUA_LIB_CODEGEN_EMITFILE_H
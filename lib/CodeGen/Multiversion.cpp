@@ -0,0 +1,205 @@
+// MIT License
+//
+// Copyright (c) 2026-onwards Iñaki Amatria-Barral
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "mua/CodeGen/CodeGen.h"
+
+#include "mua/Lower/IRUnit.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/TargetParser/Triple.h"
+#include "llvm/TargetParser/X86TargetParser.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include <array>
+
+using namespace mua;
+using namespace mua::codegen;
+
+/// Microarchitecture levels that functions may be specialized for, from the
+/// least to the most capable
+static constexpr llvm::StringLiteral Levels[]{"x86-64-v2", "x86-64-v3",
+                                              "x86-64-v4"};
+
+namespace {
+
+/// Features of the running CPU, as computed by the compiler runtime (libgcc or
+/// compiler-rt) for __builtin_cpu_supports
+struct CPUFeatures final {
+  explicit CPUFeatures(llvm::IRBuilder<> &irBuilder) : IRBuilder{irBuilder} {
+    llvm::Module &module{*IRBuilder.GetInsertBlock()->getModule()};
+    llvm::Type *i32Ty{IRBuilder.getInt32Ty()};
+    // Resolvers run before constructors, so the runtime is not initialized yet
+    IRBuilder.CreateCall(module.getOrInsertFunction(
+        "__cpu_indicator_init", IRBuilder.getVoidTy()));
+    // The first word of features is the last member of __cpu_model, the next
+    // ones are __cpu_features2
+    auto *cpuModelTy{llvm::StructType::get(i32Ty, i32Ty, i32Ty,
+                                           llvm::ArrayType::get(i32Ty, 1))};
+    Words[0] = IRBuilder.CreateLoad(
+        i32Ty, IRBuilder.CreateConstInBoundsGEP2_32(
+                   cpuModelTy, getRuntimeVariable("__cpu_model", cpuModelTy),
+                   0, 3));
+    auto *features2Ty{llvm::ArrayType::get(i32Ty, Words.size() - 1)};
+    llvm::Value *features2{getRuntimeVariable("__cpu_features2", features2Ty)};
+    for (unsigned i{1}; i < Words.size(); ++i) {
+      Words[i] = IRBuilder.CreateLoad(
+          i32Ty, IRBuilder.CreateConstInBoundsGEP2_32(features2Ty, features2,
+                                                      0, i - 1));
+    }
+  }
+
+  /// Whether the CPU supports every feature of a microarchitecture level
+  llvm::Value *supports(llvm::StringRef level) {
+    std::array<uint32_t, 4> mask{llvm::X86::getCpuSupportsMask({level})};
+    llvm::Value *result{nullptr};
+    for (auto [word, bits] : llvm::zip_equal(Words, mask)) {
+      if (bits == 0) {
+        continue;
+      }
+      llvm::Value *present{IRBuilder.CreateICmpEQ(
+          IRBuilder.CreateAnd(word, bits), IRBuilder.getInt32(bits))};
+      result = result ? IRBuilder.CreateAnd(result, present) : present;
+    }
+    return result ? result : IRBuilder.getTrue();
+  }
+
+private:
+  llvm::Value *getRuntimeVariable(llvm::StringRef name, llvm::Type *type) {
+    llvm::Module &module{*IRBuilder.GetInsertBlock()->getModule()};
+    auto *variable{llvm::cast<llvm::GlobalVariable>(
+        module.getOrInsertGlobal(name, type))};
+    variable->setDSOLocal(true);
+    return variable;
+  }
+
+  llvm::IRBuilder<> &IRBuilder;
+  std::array<llvm::Value *, 4> Words;
+};
+
+} // namespace
+
+/// Clone every defined function for a microarchitecture level. Calls in the
+/// clones refer to the clones of the same level
+static llvm::DenseMap<llvm::Function *, llvm::Function *>
+CloneForLevel(llvm::ArrayRef<llvm::Function *> functions,
+              llvm::StringRef level) {
+  llvm::StringRef suffix{level.drop_front(llvm::StringRef{"x86-64-"}.size())};
+  llvm::ValueToValueMapTy valueMap;
+  llvm::DenseMap<llvm::Function *, llvm::Function *> clones;
+  for (llvm::Function *function : functions) {
+    llvm::Function *clone{llvm::Function::Create(
+        function->getFunctionType(), llvm::Function::InternalLinkage,
+        function->getName() + "." + suffix, function->getParent())};
+    valueMap[function] = clone;
+    clones[function] = clone;
+  }
+  for (llvm::Function *function : functions) {
+    llvm::Function *clone{clones[function]};
+    for (auto [arg, cloneArg] :
+         llvm::zip_equal(function->args(), clone->args())) {
+      valueMap[&arg] = &cloneArg;
+    }
+    llvm::SmallVector<llvm::ReturnInst *, 1> returns;
+    llvm::CloneFunctionInto(clone, function, valueMap,
+                            llvm::CloneFunctionChangeType::LocalChangesOnly,
+                            returns);
+    // The level implies its features, which replace those of the target
+    clone->addFnAttr("target-cpu", level);
+    clone->removeFnAttr("target-features");
+  }
+  return clones;
+}
+
+bool mua::codegen::Multiversion(lower::IRUnit &theIRUnit,
+                                llvm::ArrayRef<std::string> cpus,
+                                llvm::raw_ostream &os) {
+  llvm::Module &module{*theIRUnit.Module};
+  llvm::Triple triple{module.getTargetTriple()};
+  if (triple.getArch() != llvm::Triple::x86_64 ||
+      !triple.isOSBinFormatELF()) {
+    os << "error: multiversioning requires an x86-64 ELF target\n";
+    return false;
+  }
+  std::vector<llvm::StringRef> levels;
+  for (llvm::StringRef level : Levels) {
+    if (llvm::is_contained(cpus, level)) {
+      levels.push_back(level);
+    }
+  }
+  for (const std::string &cpu : cpus) {
+    if (!llvm::is_contained(Levels, llvm::StringRef{cpu})) {
+      os << "error: unknown microarchitecture level " << cpu << '\n';
+      return false;
+    }
+  }
+
+  std::vector<llvm::Function *> functions;
+  for (llvm::Function &function : module) {
+    if (!function.isDeclaration()) {
+      functions.push_back(&function);
+    }
+  }
+  std::vector<llvm::DenseMap<llvm::Function *, llvm::Function *>> clones;
+  for (llvm::StringRef level : levels) {
+    clones.push_back(CloneForLevel(functions, level));
+  }
+
+  // The original functions are the baseline versions, selected when the CPU
+  // supports none of the levels
+  for (llvm::Function *function : functions) {
+    // Constants refer to the functions of the dispatch table, which hosts call
+    // without going through exported symbols
+    auto isConstant{[](const llvm::Use &use) {
+      return llvm::isa<llvm::Constant>(use.getUser());
+    }};
+    if (function->hasLocalLinkage() && llvm::none_of(function->uses(),
+                                                     isConstant)) {
+      continue;
+    }
+    std::string name{function->getName().str()};
+    llvm::GlobalValue::LinkageTypes linkage{function->getLinkage()};
+    function->setName(name + ".default");
+    function->setLinkage(llvm::Function::InternalLinkage);
+
+    auto *resolverTy{llvm::FunctionType::get(
+        llvm::PointerType::getUnqual(module.getContext()), /*isVarArg=*/false)};
+    llvm::Function *resolver{
+        llvm::Function::Create(resolverTy, llvm::Function::InternalLinkage,
+                               name + ".resolver", module)};
+    llvm::GlobalIFunc *ifunc{llvm::GlobalIFunc::create(
+        function->getFunctionType(), /*AddressSpace=*/0, linkage, name,
+        resolver, &module)};
+    function->replaceUsesWithIf(ifunc, isConstant);
+
+    llvm::IRBuilder<> irBuilder{
+        llvm::BasicBlock::Create(module.getContext(), /*Name=*/"", resolver)};
+    CPUFeatures features{irBuilder};
+    // Later levels are more capable, so they take precedence
+    llvm::Value *selected{function};
+    for (auto [level, levelClones] : llvm::zip_equal(levels, clones)) {
+      selected = irBuilder.CreateSelect(features.supports(level),
+                                        levelClones[function], selected);
+    }
+    irBuilder.CreateRet(selected);
+  }
+  return true;
+}
@@ -0,0 +1,275 @@
+// MIT License
+//
+// Copyright (c) 2026-onwards Iñaki Amatria-Barral
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#include "mua/CodeGen/CodeGen.h"
+
+#include "EmitFile.h"
+#include "mua/Lower/IRUnit.h"
+#include "llvm/ADT/EquivalenceClasses.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Twine.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/Linker/Linker.h"
+#include "llvm/Object/ArchiveWriter.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetMachine.h"
+#include "llvm/TargetParser/Triple.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include <string>
+#include <vector>
+
+using namespace mua;
+using namespace mua::codegen;
+
+namespace {
+/// Bitcode of a partition of a Module
+using Partition = llvm::SmallVector<char, 0>;
+} // namespace
+
+/// Add the global values referenced by a Constant to a set
+static void
+CollectGlobals(const llvm::Constant &constant,
+               llvm::SmallPtrSetImpl<const llvm::GlobalValue *> &globals) {
+  if (const auto *global{llvm::dyn_cast<llvm::GlobalValue>(&constant)}) {
+    globals.insert(global);
+    return;
+  }
+  for (const llvm::Use &operand : constant.operands()) {
+    CollectGlobals(*llvm::cast<llvm::Constant>(operand), globals);
+  }
+}
+
+/// Clone the given global values of a Module into bitcode. Other global values
+/// are only declared, and only if referenced
+static Partition WritePartition(
+    const llvm::Module &module,
+    const llvm::SmallPtrSetImpl<const llvm::GlobalValue *> &globals) {
+  llvm::ValueToValueMapTy valueMap;
+  std::unique_ptr<llvm::Module> clone{llvm::CloneModule(
+      module, valueMap, [&globals](const llvm::GlobalValue *global) {
+        return globals.contains(global);
+      })};
+  // Indirect functions are always cloned, even without their resolver
+  for (llvm::GlobalIFunc &ifunc :
+       llvm::make_early_inc_range(clone->ifuncs())) {
+    if (!ifunc.getResolverFunction()->isDeclaration()) {
+      continue;
+    }
+    llvm::Function *declaration{llvm::Function::Create(
+        llvm::cast<llvm::FunctionType>(ifunc.getValueType()),
+        llvm::GlobalValue::ExternalLinkage, "", clone.get())};
+    declaration->takeName(&ifunc);
+    ifunc.replaceAllUsesWith(declaration);
+    ifunc.eraseFromParent();
+  }
+  for (llvm::GlobalValue &global :
+       llvm::make_early_inc_range(clone->global_values())) {
+    if (global.isDeclaration() && global.use_empty()) {
+      global.eraseFromParent();
+    }
+  }
+
+  Partition partition;
+  llvm::raw_svector_ostream os{partition};
+  llvm::WriteBitcodeToFile(*clone, os);
+  return partition;
+}
+
+/// Split a Module into partitions of at least the given number of instructions
+/// (but the last one). Global values with local linkage are always in the same
+/// partition as the global values referencing them, as in llvm::SplitModule.
+/// Other global values are referenced from other partitions through
+/// declarations. Partitions only depend on the Module, never on how they are
+/// compiled
+static std::vector<Partition> SplitModule(const llvm::Module &module,
+                                          unsigned partitionSize) {
+  llvm::EquivalenceClasses<const llvm::GlobalValue *> clusters;
+  for (const llvm::GlobalValue &global : module.global_values()) {
+    if (global.isDeclaration()) {
+      continue;
+    }
+    clusters.insert(&global);
+    llvm::SmallPtrSet<const llvm::GlobalValue *, 8> referenced;
+    for (const llvm::Use &operand : global.operands()) {
+      CollectGlobals(*llvm::cast<llvm::Constant>(operand), referenced);
+    }
+    if (const auto *function{llvm::dyn_cast<llvm::Function>(&global)}) {
+      for (const llvm::Instruction &instruction :
+           llvm::instructions(function)) {
+        for (const llvm::Value *operand : instruction.operand_values()) {
+          if (const auto *constant{llvm::dyn_cast<llvm::Constant>(operand)}) {
+            CollectGlobals(*constant, referenced);
+          }
+        }
+      }
+    }
+    // Only local symbols cannot be resolved across partitions
+    for (const llvm::GlobalValue *other : referenced) {
+      if (!other->isDeclaration() && other->hasLocalLinkage()) {
+        clusters.unionSets(&global, other);
+      }
+    }
+  }
+
+  // Number clusters in the order of the Module, then pack consecutive clusters
+  // into partitions
+  std::vector<llvm::SmallVector<const llvm::GlobalValue *>> ordered;
+  llvm::DenseMap<const llvm::GlobalValue *, size_t> indices;
+  for (const llvm::GlobalValue &global : module.global_values()) {
+    if (global.isDeclaration()) {
+      continue;
+    }
+    auto [it, inserted]{
+        indices.try_emplace(clusters.getLeaderValue(&global), ordered.size())};
+    if (inserted) {
+      ordered.emplace_back();
+    }
+    ordered[it->second].push_back(&global);
+  }
+
+  std::vector<Partition> partitions;
+  llvm::SmallPtrSet<const llvm::GlobalValue *, 32> globals;
+  unsigned size{0};
+  for (const llvm::SmallVector<const llvm::GlobalValue *> &cluster : ordered) {
+    for (const llvm::GlobalValue *global : cluster) {
+      globals.insert(global);
+      if (const auto *function{llvm::dyn_cast<llvm::Function>(global)}) {
+        size += function->getInstructionCount();
+      }
+    }
+    if (size >= partitionSize) {
+      partitions.push_back(WritePartition(module, globals));
+      globals.clear();
+      size = 0;
+    }
+  }
+  if (!globals.empty()) {
+    partitions.push_back(WritePartition(module, globals));
+  }
+  return partitions;
+}
+
+/// Load the bitcode of a Partition into its own LLVMContext
+static lower::IRUnit LoadPartition(const Partition &partition) {
+  lower::IRUnit theIRUnit{std::make_unique<llvm::LLVMContext>(), nullptr};
+  theIRUnit.Module = llvm::cantFail(llvm::parseBitcodeFile(
+      llvm::MemoryBufferRef{llvm::StringRef{partition.data(), partition.size()},
+                            "partition"},
+      *theIRUnit.LLVMContext));
+  return theIRUnit;
+}
+
+void mua::codegen::OptimizeInParallel(lower::IRUnit &theIRUnit,
+                                      lower::OptLevel level,
+                                      const TargetOptions *targetOptions,
+                                      const ParallelOptions &options) {
+  std::vector<Partition> partitions{
+      SplitModule(*theIRUnit.Module, options.PartitionSize)};
+  llvm::DefaultThreadPool threadPool{
+      llvm::hardware_concurrency(options.Threads)};
+  for (Partition &partition : partitions) {
+    threadPool.async([&partition, level, targetOptions] {
+      lower::IRUnit partitionIRUnit{LoadPartition(partition)};
+      // Target machines are not thread-safe, so each partition creates its own
+      std::unique_ptr<llvm::TargetMachine> targetMachine;
+      if (targetOptions) {
+        targetMachine = CreateTargetMachine(*targetOptions, llvm::nulls());
+      }
+      lower::Optimize(partitionIRUnit, level, targetMachine.get());
+      partition.clear();
+      llvm::raw_svector_ostream bitcode{partition};
+      llvm::WriteBitcodeToFile(*partitionIRUnit.Module, bitcode);
+    });
+  }
+  threadPool.wait();
+
+  auto module{std::make_unique<llvm::Module>(
+      theIRUnit.Module->getModuleIdentifier(), *theIRUnit.LLVMContext)};
+  module->setSourceFileName(theIRUnit.Module->getSourceFileName());
+  module->setTargetTriple(theIRUnit.Module->getTargetTriple());
+  module->setDataLayout(theIRUnit.Module->getDataLayout());
+  llvm::Linker linker{*module};
+  for (const Partition &partition : partitions) {
+    linker.linkInModule(llvm::cantFail(llvm::parseBitcodeFile(
+        llvm::MemoryBufferRef{
+            llvm::StringRef{partition.data(), partition.size()}, "partition"},
+        *theIRUnit.LLVMContext)));
+  }
+  theIRUnit.Module = std::move(module);
+}
+
+bool mua::codegen::EmitArchive(lower::IRUnit &theIRUnit,
+                               const TargetOptions &targetOptions,
+                               const ParallelOptions &options,
+                               llvm::raw_fd_ostream &os,
+                               llvm::raw_ostream &errs) {
+  std::vector<Partition> partitions{
+      SplitModule(*theIRUnit.Module, options.PartitionSize)};
+  std::vector<std::string> errors(partitions.size());
+  llvm::DefaultThreadPool threadPool{
+      llvm::hardware_concurrency(options.Threads)};
+  for (size_t i = 0; i < partitions.size(); ++i) {
+    threadPool.async([&partitions, &errors, &targetOptions, i] {
+      lower::IRUnit partitionIRUnit{LoadPartition(partitions[i])};
+      // Target machines are not thread-safe, so each partition creates its own
+      std::unique_ptr<llvm::TargetMachine> targetMachine{
+          CreateTargetMachine(targetOptions, llvm::nulls())};
+      lower::Optimize(partitionIRUnit, targetOptions.Level,
+                      targetMachine.get());
+      partitions[i].clear();
+      llvm::raw_svector_ostream object{partitions[i]};
+      llvm::raw_string_ostream diagnostics{errors[i]};
+      EmitFile(partitionIRUnit, *targetMachine, FileKind::Object, object,
+               diagnostics);
+    });
+  }
+  threadPool.wait();
+  for (const std::string &error : errors) {
+    if (!error.empty()) {
+      errs << error;
+      return false;
+    }
+  }
+
+  // Name members after the source file, numbered in partition order
+  llvm::StringRef stem{
+      llvm::sys::path::stem(theIRUnit.Module->getSourceFileName())};
+  std::vector<std::string> names;
+  for (size_t i = 0; i < partitions.size(); ++i) {
+    names.push_back((stem + "." + llvm::Twine{i} + ".o").str());
+  }
+  std::vector<llvm::NewArchiveMember> members;
+  for (size_t i = 0; i < partitions.size(); ++i) {
+    members.emplace_back(llvm::MemoryBufferRef{
+        llvm::StringRef{partitions[i].data(), partitions[i].size()},
+        names[i]});
+  }
+  return WriteArchive(members,
+                      llvm::Triple{theIRUnit.Module->getTargetTriple()}, os,
+                      errs);
+}
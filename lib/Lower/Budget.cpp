@@ -0,0 +1,215 @@
+// MIT License
+//
+// Copyright (c) 2026-onwards Iñaki Amatria-Barral
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "mua/Lower/Lower.h"
+
+#include "mua/AST/Walker.h"
+#include "mua/Sema/Annotation.h"
+#include "mua/Sema/CallGraph.h"
+#include "mua/Sema/Symbol.h"
+#include "mua/Support/ErrorHandling.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include <array>
+#include <numeric>
+
+using namespace mua;
+using namespace mua::lower;
+
+namespace {
+
+/// Levels a function may be optimized at, from the cheapest
+constexpr std::array<OptLevel, 3> BudgetLevels{OptLevel::O0, OptLevel::O1,
+                                               OptLevel::O3};
+
+/// Estimated milliseconds to optimize and generate code for one AST Node at a
+/// level. These are rough figures: estimates only need to grow with the size
+/// of functions and to rank the levels
+double getNodeCost(OptLevel level) {
+  switch (level) {
+  case OptLevel::O0:
+    return 0.002;
+  case OptLevel::O1:
+    return 0.01;
+  case OptLevel::O2:
+  case OptLevel::O3:
+  case OptLevel::Os:
+    return 0.03;
+  }
+  MUA_COVERS_ALL_CASES;
+}
+
+/// Loops are unrolled and vectorized at O3, which multiplies their bodies
+constexpr double LoopFactorO3{4};
+
+/// Non-recursive callees of at most this many Nodes are expected to be inlined
+/// from O1
+constexpr unsigned InlineSize{50};
+
+llvm::StringRef getName(OptLevel level) {
+  switch (level) {
+  case OptLevel::O0:
+    return "O0";
+  case OptLevel::O1:
+    return "O1";
+  case OptLevel::O2:
+    return "O2";
+  case OptLevel::O3:
+    return "O3";
+  case OptLevel::Os:
+    return "Os";
+  }
+  MUA_COVERS_ALL_CASES;
+}
+
+/// Size of a function, in AST Nodes
+struct Size final {
+  unsigned Nodes{0};
+  /// Nodes within loops
+  unsigned LoopNodes{0};
+};
+
+/// Counts the AST Nodes of a FunctionDecl
+struct SizeVisitor final {
+  template <typename T> bool onEnter(const T &) { return true; }
+  template <typename T> void onExit(const T &) {}
+
+  bool onEnter(const ast::Node &) {
+    ++TheSize.Nodes;
+    if (LoopDepth > 0) {
+      ++TheSize.LoopNodes;
+    }
+    return true;
+  }
+
+  bool onEnter(const ast::ForStmt &) {
+    ++LoopDepth;
+    return true;
+  }
+
+  void onExit(const ast::ForStmt &) { --LoopDepth; }
+
+  Size TheSize;
+
+private:
+  unsigned LoopDepth{0};
+};
+
+/// Estimated milliseconds to optimize and generate code for a function of the
+/// given size at a level
+double estimate(Size size, OptLevel level) {
+  double nodes{static_cast<double>(size.Nodes)};
+  if (level == OptLevel::O3) {
+    nodes += (LoopFactorO3 - 1) * size.LoopNodes;
+  }
+  return nodes * getNodeCost(level);
+}
+
+} // namespace
+
+std::vector<FunctionOptLevel>
+mua::lower::PlanOptLevels(const ast::TranslationUnit &tu,
+                          const sema::Scope &scope, double budget) {
+  sema::CallGraph callGraph{tu, scope};
+  llvm::DenseMap<const sema::Symbol *, Size> sizes;
+  llvm::DenseMap<const sema::Symbol *, unsigned> callers;
+  for (const ast::FunctionDeclPtr &fn : tu.getFNs()) {
+    const sema::Symbol *symbol{scope.lookup(fn->getName())};
+    SizeVisitor sizeVisitor;
+    ast::Walk(*fn, sizeVisitor);
+    sizes[symbol] = sizeVisitor.TheSize;
+    for (const sema::Symbol *callee : callGraph.getCallees(symbol)) {
+      ++callers[callee];
+    }
+  }
+
+  // Start from O0, which every function must pay for
+  std::vector<FunctionOptLevel> levels;
+  std::vector<std::array<double, BudgetLevels.size()>> costs;
+  std::vector<double> priorities;
+  double total{0};
+  for (const ast::FunctionDeclPtr &fn : tu.getFNs()) {
+    const sema::Symbol *symbol{scope.lookup(fn->getName())};
+    // Optimizing a function also optimizes the callees inlined into it
+    Size inlined{sizes[symbol]};
+    for (const sema::Symbol *callee : callGraph.getCallees(symbol)) {
+      Size size{sizes[callee]};
+      if (size.Nodes <= InlineSize && !callGraph.isRecursive(callee)) {
+        inlined.Nodes += size.Nodes;
+        inlined.LoopNodes += size.LoopNodes;
+      }
+    }
+    std::array<double, BudgetLevels.size()> cost;
+    for (auto [level, levelCost] : llvm::zip_equal(BudgetLevels, cost)) {
+      levelCost = estimate(level == OptLevel::O0 ? sizes[symbol] : inlined,
+                           level);
+    }
+    levels.push_back({llvm::StringRef{symbol->getName()}.str(), OptLevel::O0,
+                      cost.front()});
+    costs.push_back(cost);
+    total += cost.front();
+    // Hot functions first, then those cheapest to optimize for each of their
+    // callers, which share the gains
+    priorities.push_back(
+        sema::HasAnnotation(*fn, sema::Annotation::ID::Hot)
+            ? 0
+            : cost.back() / (1 + callers.lookup(symbol)));
+  }
+
+  // Raise each function, in order of priority, to the highest level that still
+  // fits. Giant functions are left for last, so that they do not take the
+  // budget of many small ones
+  std::vector<size_t> order(levels.size());
+  std::iota(order.begin(), order.end(), 0);
+  llvm::stable_sort(order, [&](size_t lhs, size_t rhs) {
+    return priorities[lhs] < priorities[rhs];
+  });
+  for (size_t i : order) {
+    for (size_t level{BudgetLevels.size() - 1}; level > 0; --level) {
+      double extra{costs[i][level] - costs[i].front()};
+      if (total + extra <= budget) {
+        levels[i].Level = BudgetLevels[level];
+        levels[i].EstimatedMs = costs[i][level];
+        total += extra;
+        break;
+      }
+    }
+  }
+  return levels;
+}
+
+void mua::lower::ReportOptLevels(llvm::ArrayRef<FunctionOptLevel> levels,
+                                 double budget, llvm::raw_ostream &os) {
+  double total{0};
+  for (const FunctionOptLevel &level : levels) {
+    total += level.EstimatedMs;
+  }
+  os << llvm::format("compile budget: %.3f ms, estimated: %.3f ms\n", budget,
+                     total);
+  for (const FunctionOptLevel &level : levels) {
+    os << llvm::format("  %s %10.3f ms  ", getName(level.Level).data(),
+                       level.EstimatedMs)
+       << level.Name << '\n';
+  }
+}
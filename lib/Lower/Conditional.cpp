@@ -0,0 +1,126 @@
+// MIT License
+//
+// Copyright (c) 2026-onwards Iñaki Amatria-Barral
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "Conditional.h"
+
+#include "mua/AST/Walker.h"
+#include "mua/Sema/Builtin.h"
+#include "mua/Support/ErrorHandling.h"
+
+using namespace mua;
+using namespace mua::lower;
+
+namespace {
+
+/// Number of operations that the branches of a ConditionalExpr lowered as a
+/// select may compute together. Evaluating both is then cheaper than a branch
+/// the target may mispredict
+constexpr unsigned SelectBudget{8};
+
+/// Counts the operations of a branch, giving up on those that cannot be
+/// evaluated speculatively
+struct CostVisitor final {
+  template <typename T> bool onEnter(const T &) { return true; }
+  template <typename T> void onExit(const T &) {}
+
+  bool onEnter(const ast::CallExpr &call) {
+    const sema::Builtin *builtin{sema::LookupBuiltin(call.getCallee())};
+    if (!builtin || builtin->TheID == sema::Builtin::ID::Exp ||
+        builtin->TheID == sema::Builtin::ID::Log ||
+        builtin->TheID == sema::Builtin::ID::Pow) {
+      Speculatable = false;
+      return false;
+    }
+    ++Cost;
+    return true;
+  }
+
+  bool onEnter(const ast::BinaryExpr &) {
+    ++Cost;
+    return true;
+  }
+
+  bool onEnter(const ast::ConditionalExpr &) {
+    ++Cost;
+    return true;
+  }
+
+  unsigned Cost{0};
+  bool Speculatable{true};
+};
+
+} // namespace
+
+llvm::CmpInst::Predicate mua::lower::GetFCmpPredicate(ast::BinaryExpr::Op op) {
+  switch (op) {
+  case ast::BinaryExpr::Op::Less:
+    return llvm::CmpInst::FCMP_OLT;
+  case ast::BinaryExpr::Op::LessEqual:
+    return llvm::CmpInst::FCMP_OLE;
+  case ast::BinaryExpr::Op::Greater:
+    return llvm::CmpInst::FCMP_OGT;
+  case ast::BinaryExpr::Op::GreaterEqual:
+    return llvm::CmpInst::FCMP_OGE;
+  case ast::BinaryExpr::Op::Equal:
+    return llvm::CmpInst::FCMP_OEQ;
+  case ast::BinaryExpr::Op::NotEqual:
+    return llvm::CmpInst::FCMP_UNE;
+  case ast::BinaryExpr::Op::Assign:
+  case ast::BinaryExpr::Op::Add:
+  case ast::BinaryExpr::Op::Sub:
+  case ast::BinaryExpr::Op::Mul:
+  case ast::BinaryExpr::Op::Div:
+    break;
+  }
+  MUA_COVERS_ALL_CASES;
+}
+
+llvm::CmpInst::Predicate mua::lower::GetICmpPredicate(ast::BinaryExpr::Op op) {
+  switch (op) {
+  case ast::BinaryExpr::Op::Less:
+    return llvm::CmpInst::ICMP_SLT;
+  case ast::BinaryExpr::Op::LessEqual:
+    return llvm::CmpInst::ICMP_SLE;
+  case ast::BinaryExpr::Op::Greater:
+    return llvm::CmpInst::ICMP_SGT;
+  case ast::BinaryExpr::Op::GreaterEqual:
+    return llvm::CmpInst::ICMP_SGE;
+  case ast::BinaryExpr::Op::Equal:
+    return llvm::CmpInst::ICMP_EQ;
+  case ast::BinaryExpr::Op::NotEqual:
+    return llvm::CmpInst::ICMP_NE;
+  case ast::BinaryExpr::Op::Assign:
+  case ast::BinaryExpr::Op::Add:
+  case ast::BinaryExpr::Op::Sub:
+  case ast::BinaryExpr::Op::Mul:
+  case ast::BinaryExpr::Op::Div:
+    break;
+  }
+  MUA_COVERS_ALL_CASES;
+}
+
+bool mua::lower::ShouldSelect(const ast::ConditionalExpr &cond) {
+  CostVisitor costVisitor;
+  ast::Walk(*cond.getThen(), costVisitor);
+  ast::Walk(*cond.getElse(), costVisitor);
+  return costVisitor.Speculatable && costVisitor.Cost <= SelectBudget;
+}
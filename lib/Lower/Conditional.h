@@ -0,0 +1,46 @@
+// MIT License
+//
+// Copyright (c) 2026-onwards Iñaki Amatria-Barral
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef MUA_LIB_LOWER_CONDITIONAL_H
+#define MUA_LIB_LOWER_CONDITIONAL_H
+
+#include "mua/AST/Expr.h"
+#include "llvm/IR/InstrTypes.h"
+
+namespace mua::lower {
+
+/// Predicate of the fcmp computing a comparison operator. ~= is unordered, so
+/// it holds if an operand is NaN, while every other comparison is ordered
+llvm::CmpInst::Predicate GetFCmpPredicate(ast::BinaryExpr::Op);
+
+/// Predicate of the icmp computing a comparison operator on i64 operands
+llvm::CmpInst::Predicate GetICmpPredicate(ast::BinaryExpr::Op);
+
+/// Whether a ConditionalExpr is lowered as a select, evaluating both branches,
+/// rather than as a conditional branch. Branches must be cheap and free of
+/// calls that may not return: a few arithmetic operations and Builtins other
+/// than the ones lowered as calls to the math library
+bool ShouldSelect(const ast::ConditionalExpr &);
+
+} // namespace mua::lower
+
+#endif // MUA_LIB_LOWER_CONDITIONAL_H
@@ -0,0 +1,358 @@
+// MIT License
+//
+// Copyright (c) 2026-onwards Iñaki Amatria-Barral
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "Dispatch.h"
+
+#include "Loop.h"
+#include "mua/AST/TranslationUnit.h"
+#include "mua/Sema/Sema.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Verifier.h"
+#include "llvm/Support/MathExtras.h"
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <optional>
+#include <vector>
+
+using namespace mua;
+using namespace mua::lower;
+
+namespace {
+
+/// Offset basis and prime of the 64-bit FNV-1a hash
+constexpr std::uint64_t FNVOffsetBasis{0xcbf29ce484222325};
+constexpr std::uint64_t FNVPrime{0x100000001b3};
+/// Multipliers of the finalizer of MurmurHash3
+constexpr std::uint64_t MixMultipliers[]{0xff51afd7ed558ccd,
+                                         0xc4ceb9fe1a85ec53};
+/// Displacements tried for a bucket before the table is grown
+constexpr std::uint32_t MaxDisplacement{1 << 16};
+/// Name length of empty slots, which no name has
+constexpr std::uint64_t EmptyLength{~std::uint64_t{0}};
+
+/// Spread every bit of a hash to its low bits, which index tables
+std::uint64_t mix(std::uint64_t hash) {
+  for (std::uint64_t multiplier : MixMultipliers) {
+    hash ^= hash >> 33;
+    hash *= multiplier;
+  }
+  return hash ^ (hash >> 33);
+}
+
+/// Hash of a name: 64-bit FNV-1a, then mixed. Must match the function emitted
+/// by emitHash
+std::uint64_t hashName(llvm::StringRef name) {
+  std::uint64_t hash{FNVOffsetBasis};
+  for (unsigned char c : name) {
+    hash = (hash ^ c) * FNVPrime;
+  }
+  return mix(hash);
+}
+
+/// Slot of a name from its hash and the displacement of its bucket, without
+/// hashing the name again. Must match the accessor emitted by emitAccessor
+std::uint64_t getSlot(std::uint64_t hash, std::uint32_t displacement,
+                      std::uint64_t mask) {
+  return mix(hash ^ displacement) & mask;
+}
+
+/// Perfect hash of a set of names, by hash and displace: names are grouped in
+/// buckets by the low bits of their hash, then each bucket, largest first,
+/// gets the first displacement under which the hashes of its names remix to
+/// distinct free slots. There are as many buckets as slots, a power of two
+struct PerfectHash final {
+  std::vector<std::uint32_t> Displacements;
+  /// Index of the name in every slot, if any
+  std::vector<std::optional<std::size_t>> Slots;
+};
+
+std::optional<PerfectHash>
+buildPerfectHash(llvm::ArrayRef<llvm::StringRef> names, std::size_t size) {
+  std::uint64_t mask{size - 1};
+  std::vector<std::uint64_t> hashes;
+  std::vector<std::vector<std::size_t>> buckets(size);
+  for (std::size_t name{0}; name < names.size(); ++name) {
+    hashes.push_back(hashName(names[name]));
+    buckets[hashes.back() & mask].push_back(name);
+  }
+  std::vector<std::size_t> order(size);
+  std::iota(order.begin(), order.end(), 0);
+  llvm::stable_sort(order, [&](std::size_t lhs, std::size_t rhs) {
+    return buckets[lhs].size() > buckets[rhs].size();
+  });
+
+  PerfectHash hash{std::vector<std::uint32_t>(size),
+                   std::vector<std::optional<std::size_t>>(size)};
+  for (std::size_t bucket : order) {
+    if (buckets[bucket].empty()) {
+      break;
+    }
+    std::vector<std::uint64_t> slots;
+    std::uint32_t displacement{0};
+    for (; displacement < MaxDisplacement; ++displacement) {
+      slots.clear();
+      for (std::size_t name : buckets[bucket]) {
+        std::uint64_t slot{getSlot(hashes[name], displacement, mask)};
+        if (hash.Slots[slot] || llvm::is_contained(slots, slot)) {
+          break;
+        }
+        slots.push_back(slot);
+      }
+      if (slots.size() == buckets[bucket].size()) {
+        break;
+      }
+    }
+    if (displacement == MaxDisplacement) {
+      return std::nullopt;
+    }
+    hash.Displacements[bucket] = displacement;
+    for (auto [slot, name] : llvm::zip_equal(slots, buckets[bucket])) {
+      hash.Slots[slot] = name;
+    }
+  }
+  return hash;
+}
+
+/// Grow the table from the smallest power of two holding every name until the
+/// names hash perfectly into it
+PerfectHash buildPerfectHash(llvm::ArrayRef<llvm::StringRef> names) {
+  for (std::size_t size{llvm::PowerOf2Ceil(
+           std::max<std::size_t>(names.size(), 1))};
+       ; size *= 2) {
+    if (std::optional<PerfectHash> hash{buildPerfectHash(names, size)}) {
+      return std::move(*hash);
+    }
+  }
+}
+
+/// Emit mix of a hash
+llvm::Value *emitMix(llvm::IRBuilderBase &irBuilder, llvm::Value *hash) {
+  for (std::uint64_t multiplier : MixMultipliers) {
+    hash = irBuilder.CreateXor(hash, irBuilder.CreateLShr(hash, 33));
+    hash = irBuilder.CreateMul(hash, irBuilder.getInt64(multiplier));
+  }
+  return irBuilder.CreateXor(hash, irBuilder.CreateLShr(hash, 33));
+}
+
+/// Emit `i64 mua.hash(ptr name, i64 length)`, computing hashName
+llvm::Function *emitHash(llvm::Module &module) {
+  llvm::LLVMContext &context{module.getContext()};
+  llvm::Type *i64Ty{llvm::Type::getInt64Ty(context)};
+  auto *hashTy{llvm::FunctionType::get(
+      i64Ty, {llvm::PointerType::getUnqual(context), i64Ty},
+      /*isVarArg=*/false)};
+  llvm::Function *function{llvm::Function::Create(
+      hashTy, llvm::Function::InternalLinkage, "mua.hash", module)};
+  function->setOnlyAccessesArgMemory();
+  function->setOnlyReadsMemory();
+  function->setDoesNotThrow();
+  function->addFnAttr(llvm::Attribute::NoSync);
+  function->setWillReturn();
+
+  llvm::IRBuilder<> irBuilder{
+      llvm::BasicBlock::Create(context, /*Name=*/"", function)};
+  llvm::Value *name{function->getArg(0)};
+  CountedLoop loop{irBuilder, irBuilder.getInt64(0),
+                   irBuilder.CreateSub(function->getArg(1),
+                                       irBuilder.getInt64(1))};
+  llvm::PHINode *hash{loop.addCarried(irBuilder.getInt64(FNVOffsetBasis),
+                                      "hash")};
+  llvm::Value *c{irBuilder.CreateLoad(
+      irBuilder.getInt8Ty(),
+      irBuilder.CreateGEP(irBuilder.getInt8Ty(), name, loop.getIndex()))};
+  llvm::Value *next{irBuilder.CreateMul(
+      irBuilder.CreateXor(hash, irBuilder.CreateZExt(c, i64Ty)),
+      irBuilder.getInt64(FNVPrime))};
+  irBuilder.CreateRet(emitMix(irBuilder, loop.close({next}).front()));
+  return function;
+}
+
+/// Emit `T f.call(ptr args)`, calling a function f with its arguments read
+/// from an array
+llvm::Function *emitTrampoline(llvm::Function &function) {
+  llvm::LLVMContext &context{function.getContext()};
+  llvm::Type *fpTy{function.getReturnType()};
+  auto *trampolineTy{
+      llvm::FunctionType::get(fpTy, {llvm::PointerType::getUnqual(context)},
+                              /*isVarArg=*/false)};
+  llvm::Function *trampoline{llvm::Function::Create(
+      trampolineTy, llvm::Function::InternalLinkage,
+      function.getName() + ".call", function.getParent())};
+  bool strict{function.hasFnAttribute(llvm::Attribute::StrictFP)};
+  if (strict) {
+    // Calls access the floating-point environment
+    trampoline->addFnAttr(llvm::Attribute::StrictFP);
+  } else {
+    trampoline->setOnlyAccessesArgMemory();
+    trampoline->setOnlyReadsMemory();
+  }
+  trampoline->setDoesNotThrow();
+  trampoline->addFnAttr(llvm::Attribute::NoSync);
+  trampoline->addParamAttr(0, llvm::Attribute::ReadOnly);
+
+  llvm::IRBuilder<> irBuilder{
+      llvm::BasicBlock::Create(context, /*Name=*/"", trampoline)};
+  std::vector<llvm::Value *> args;
+  for (unsigned i{0}; i < function.arg_size(); ++i) {
+    args.push_back(irBuilder.CreateLoad(
+        fpTy, irBuilder.CreateConstInBoundsGEP1_64(fpTy, trampoline->getArg(0),
+                                                   i)));
+  }
+  llvm::CallInst *call{irBuilder.CreateCall(&function, args)};
+  call->setCallingConv(function.getCallingConv());
+  if (strict) {
+    call->addFnAttr(llvm::Attribute::StrictFP);
+  }
+  irBuilder.CreateRet(call);
+  return trampoline;
+}
+
+/// Emit the accessor of a table: the name is hashed once, and the displacement
+/// of its bucket remixes the hash to its only possible slot, which holds it if
+/// the names are equal
+void emitAccessor(llvm::Module &module, llvm::StructType *entryTy,
+                  llvm::GlobalVariable &entries,
+                  llvm::GlobalVariable &displacements) {
+  llvm::LLVMContext &context{module.getContext()};
+  auto *ptrTy{llvm::PointerType::getUnqual(context)};
+  llvm::Type *i64Ty{llvm::Type::getInt64Ty(context)};
+  llvm::Function *hash{emitHash(module)};
+  llvm::Function *accessor{llvm::Function::Create(
+      llvm::FunctionType::get(ptrTy, {ptrTy, i64Ty}, /*isVarArg=*/false),
+      llvm::Function::ExternalLinkage, sema::DispatchAccessor, module)};
+  accessor->setOnlyReadsMemory();
+  accessor->setDoesNotThrow();
+  accessor->addFnAttr(llvm::Attribute::NoSync);
+  accessor->addParamAttr(0, llvm::Attribute::ReadOnly);
+
+  llvm::IRBuilder<> irBuilder{
+      llvm::BasicBlock::Create(context, /*Name=*/"", accessor)};
+  llvm::Value *name{accessor->getArg(0)};
+  llvm::Value *length{accessor->getArg(1)};
+  llvm::Value *mask{irBuilder.getInt64(
+      llvm::cast<llvm::ArrayType>(entries.getValueType())->getNumElements() -
+      1)};
+  llvm::Value *nameHash{irBuilder.CreateCall(hash, {name, length})};
+  llvm::Value *bucket{irBuilder.CreateAnd(nameHash, mask)};
+  llvm::Value *displacement{irBuilder.CreateZExt(
+      irBuilder.CreateLoad(
+          irBuilder.getInt32Ty(),
+          irBuilder.CreateInBoundsGEP(displacements.getValueType(),
+                                      &displacements,
+                                      {irBuilder.getInt64(0), bucket})),
+      i64Ty)};
+  llvm::Value *slot{irBuilder.CreateAnd(
+      emitMix(irBuilder, irBuilder.CreateXor(nameHash, displacement)), mask)};
+  llvm::Value *entry{irBuilder.CreateInBoundsGEP(
+      entries.getValueType(), &entries, {irBuilder.getInt64(0), slot},
+      "entry")};
+
+  // Only names of the same length are compared
+  auto *compare{llvm::BasicBlock::Create(context, "compare", accessor)};
+  auto *miss{llvm::BasicBlock::Create(context, "miss", accessor)};
+  llvm::Value *entryLength{irBuilder.CreateLoad(
+      i64Ty, irBuilder.CreateStructGEP(entryTy, entry, 1))};
+  irBuilder.CreateCondBr(irBuilder.CreateICmpEQ(entryLength, length), compare,
+                         miss);
+
+  irBuilder.SetInsertPoint(compare);
+  llvm::FunctionCallee memcmp{module.getOrInsertFunction(
+      "memcmp", irBuilder.getInt32Ty(), ptrTy, ptrTy, i64Ty)};
+  llvm::Value *entryName{irBuilder.CreateLoad(
+      ptrTy, irBuilder.CreateStructGEP(entryTy, entry, 0))};
+  llvm::Value *equal{irBuilder.CreateICmpEQ(
+      irBuilder.CreateCall(memcmp, {entryName, name, length}),
+      irBuilder.getInt32(0))};
+  llvm::Constant *null{llvm::ConstantPointerNull::get(ptrTy)};
+  irBuilder.CreateRet(irBuilder.CreateSelect(equal, entry, null));
+
+  irBuilder.SetInsertPoint(miss);
+  irBuilder.CreateRet(null);
+  assert(!llvm::verifyFunction(*hash));
+  assert(!llvm::verifyFunction(*accessor));
+}
+
+} // namespace
+
+void mua::lower::EmitDispatchTable(const ast::TranslationUnit &tu,
+                                   llvm::Module &module) {
+  std::vector<llvm::StringRef> names;
+  std::vector<llvm::Function *> functions;
+  for (const ast::FunctionDeclPtr &fn : tu.getFNs()) {
+    llvm::Function *function{module.getFunction(fn->getName())};
+    if (!function->hasLocalLinkage()) {
+      names.push_back(fn->getName());
+      functions.push_back(function);
+    }
+  }
+  // Trampolines are emitted in source order, independently of the hash
+  std::vector<llvm::Function *> trampolines;
+  for (llvm::Function *function : functions) {
+    trampolines.push_back(emitTrampoline(*function));
+    assert(!llvm::verifyFunction(*trampolines.back()));
+  }
+
+  PerfectHash hash{buildPerfectHash(names)};
+  llvm::LLVMContext &context{module.getContext()};
+  auto *ptrTy{llvm::PointerType::getUnqual(context)};
+  llvm::Type *i64Ty{llvm::Type::getInt64Ty(context)};
+  llvm::StructType *entryTy{llvm::StructType::create(
+      context, {ptrTy, i64Ty, ptrTy, ptrTy, i64Ty}, "mua_function")};
+  auto *null{llvm::ConstantPointerNull::get(ptrTy)};
+  std::vector<llvm::Constant *> entries;
+  for (std::optional<std::size_t> slot : hash.Slots) {
+    if (!slot) {
+      entries.push_back(llvm::ConstantStruct::get(
+          entryTy, {null, llvm::ConstantInt::get(i64Ty, EmptyLength), null,
+                    null, llvm::ConstantInt::get(i64Ty, 0)}));
+      continue;
+    }
+    // Names are null-terminated for the convenience of C hosts
+    llvm::Constant *string{
+        llvm::ConstantDataArray::getString(context, names[*slot])};
+    auto *name{new llvm::GlobalVariable{
+        module, string->getType(), /*isConstant=*/true,
+        llvm::GlobalValue::PrivateLinkage, string, "mua.name"}};
+    name->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
+    entries.push_back(llvm::ConstantStruct::get(
+        entryTy,
+        {name, llvm::ConstantInt::get(i64Ty, names[*slot].size()),
+         functions[*slot], trampolines[*slot],
+         llvm::ConstantInt::get(i64Ty, functions[*slot]->arg_size())}));
+  }
+
+  llvm::Constant *entriesInit{llvm::ConstantArray::get(
+      llvm::ArrayType::get(entryTy, entries.size()), entries)};
+  auto *entriesVar{new llvm::GlobalVariable{
+      module, entriesInit->getType(), /*isConstant=*/true,
+      llvm::GlobalValue::PrivateLinkage, entriesInit, "mua.dispatch"}};
+  llvm::Constant *displacementsInit{
+      llvm::ConstantDataArray::get(context, hash.Displacements)};
+  auto *displacementsVar{new llvm::GlobalVariable{
+      module, displacementsInit->getType(), /*isConstant=*/true,
+      llvm::GlobalValue::PrivateLinkage, displacementsInit,
+      "mua.dispatch.displacements"}};
+  emitAccessor(module, entryTy, *entriesVar, *displacementsVar);
+}
@@ -0,0 +1,48 @@
+// MIT License
+//
+// Copyright (c) 2026-onwards Iñaki Amatria-Barral
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef MUA_LIB_LOWER_DISPATCH_H
+#define MUA_LIB_LOWER_DISPATCH_H
+
+namespace llvm {
+class Module;
+} // namespace llvm
+
+namespace mua::ast {
+struct TranslationUnit;
+} // namespace mua::ast
+
+namespace mua::lower {
+
+/// Emit a constant table of every function of the TranslationUnit exported by
+/// the Module, and the accessor `ptr mua_lookup(ptr name, i64 length)`
+/// returning the entry of the function of the given name, or null. Entries are
+/// `{ptr name, i64 length, ptr function, ptr call, i64 arity}`, where call is a
+/// trampoline `T (ptr args)` reading the arity arguments of the function from
+/// an array. The table is indexed by a perfect hash of the names, so a lookup
+/// takes one probe and one comparison of names. Every function must already be
+/// in the Module
+void EmitDispatchTable(const ast::TranslationUnit &, llvm::Module &);
+
+} // namespace mua::lower
+
+#endif // MUA_LIB_LOWER_DISPATCH_H
@@ -0,0 +1,499 @@
+// MIT License
+//
+// Copyright (c) 2026-onwards Iñaki Amatria-Barral
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "Gradient.h"
+
+#include "Conditional.h"
+#include "Intrinsics.h"
+#include "Loop.h"
+#include "mua/AST/TranslationUnit.h"
+#include "mua/Sema/Builtin.h"
+#include "mua/Sema/CallGraph.h"
+#include "mua/Sema/Sema.h"
+#include "mua/Sema/Symbol.h"
+#include "mua/Support/ErrorHandling.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Verifier.h"
+#include <algorithm>
+#include <optional>
+
+using namespace mua;
+using namespace mua::lower;
+
+namespace {
+
+/// A dual number: a value and its partial derivatives with respect to each
+/// parameter of the function being differentiated
+struct Dual final {
+  llvm::Value *Value;
+  /// Vector with one lane per parameter
+  llvm::Value *Tangent;
+};
+
+/// Emits the body of the gradient companion of a function
+struct GradientEmitter final {
+  GradientEmitter(const sema::Scope &scope, llvm::Function &companion)
+      : TheScope{scope}, Companion{companion},
+        IRBuilder{llvm::BasicBlock::Create(companion.getContext(),
+                                           /*Name=*/"", &companion)},
+        Width{static_cast<unsigned>(companion.arg_size() - 1)},
+        FPTy{companion.getReturnType()},
+        TangentTy{llvm::FixedVectorType::get(FPTy, std::max(Width, 1U))} {}
+
+  void emit(const ast::FunctionDecl &fn) {
+    llvm::Module &module{*Companion.getParent()};
+    std::vector<const sema::Symbol *> params{
+        TheScope.getSymbols(sema::Symbol::Kind::Param)};
+    for (unsigned index{0}; index < Width; ++index) {
+      // The tangent of a parameter is the unit vector of its lane
+      std::vector<llvm::Constant *> unit{Width, getZero(FPTy)};
+      unit[index] = llvm::ConstantFP::get(FPTy, 1);
+      Values[params[index]] = {Companion.getArg(index),
+                               llvm::ConstantVector::get(unit)};
+    }
+    for (const ast::StmtPtr &stmt : fn.getBody()->getStmts()) {
+      if (const auto *rs{llvm::dyn_cast<ast::ReturnStmt>(stmt.get())}) {
+        Dual result{lower(*rs->getValue())};
+        // Without parameters there is nothing to differentiate with respect
+        // to, and the caller's array may be empty
+        if (Width > 0) {
+          // The caller's array is only known to be aligned as its elements
+          IRBuilder.CreateAlignedStore(
+              result.Tangent, Companion.getArg(Width),
+              module.getDataLayout().getABITypeAlign(FPTy));
+        }
+        IRBuilder.CreateRet(result.Value);
+      } else {
+        lowerStmt(*stmt);
+      }
+    }
+  }
+
+private:
+  static llvm::Constant *getZero(llvm::Type *type) {
+    return llvm::Constant::getNullValue(type);
+  }
+
+  static bool isZero(llvm::Value *tangent) {
+    return llvm::isa<llvm::ConstantAggregateZero>(tangent);
+  }
+
+  llvm::Value *splat(llvm::Value *value) {
+    return IRBuilder.CreateVectorSplat(Width, value);
+  }
+
+  /// Tangent scaled by a value, skipping zero tangents
+  llvm::Value *scale(llvm::Value *tangent, llvm::Value *factor) {
+    if (isZero(tangent)) {
+      return tangent;
+    }
+    return IRBuilder.CreateFMul(tangent, splat(factor));
+  }
+
+  /// Tangent divided by a value, skipping zero tangents
+  llvm::Value *divide(llvm::Value *tangent, llvm::Value *divisor) {
+    if (isZero(tangent)) {
+      return tangent;
+    }
+    return IRBuilder.CreateFDiv(tangent, splat(divisor));
+  }
+
+  llvm::Value *add(llvm::Value *lhs, llvm::Value *rhs) {
+    if (isZero(lhs)) {
+      return rhs;
+    }
+    if (isZero(rhs)) {
+      return lhs;
+    }
+    return IRBuilder.CreateFAdd(lhs, rhs);
+  }
+
+  llvm::Value *sub(llvm::Value *lhs, llvm::Value *rhs) {
+    if (isZero(rhs)) {
+      return lhs;
+    }
+    if (isZero(lhs)) {
+      return IRBuilder.CreateFNeg(rhs);
+    }
+    return IRBuilder.CreateFSub(lhs, rhs);
+  }
+
+  Dual lower(const ast::Expr &expr) {
+    switch (expr.getKind()) {
+    case ast::Node::Kind::NumberExpr: {
+      const auto &ne{static_cast<const ast::NumberExpr &>(expr)};
+      return {llvm::ConstantFP::get(FPTy, ne.getValue()), getZero(TangentTy)};
+    }
+    case ast::Node::Kind::IdentifierExpr: {
+      const auto &id{static_cast<const ast::IdentifierExpr &>(expr)};
+      auto it{Values.find(TheScope.lookup(id.getName()))};
+      if (it == Values.end()) {
+        // Read before any assignment: the value is undefined
+        return {llvm::PoisonValue::get(FPTy), getZero(TangentTy)};
+      }
+      return it->second;
+    }
+    case ast::Node::Kind::CallExpr:
+      return lowerCall(static_cast<const ast::CallExpr &>(expr));
+    case ast::Node::Kind::BinaryExpr: {
+      const auto &bin{static_cast<const ast::BinaryExpr &>(expr)};
+      if (bin.getOp() == ast::BinaryExpr::Op::Assign) {
+        const auto &id{static_cast<const ast::IdentifierExpr &>(*bin.getLHS())};
+        Dual value{lower(*bin.getRHS())};
+        Values[TheScope.lookup(id.getName())] = value;
+        return value;
+      }
+      if (ast::IsComparison(bin.getOp())) {
+        // Comparisons are piecewise constant
+        return {IRBuilder.CreateUIToFP(lowerComparison(bin), FPTy),
+                getZero(TangentTy)};
+      }
+      Dual lhs{lower(*bin.getLHS())};
+      Dual rhs{lower(*bin.getRHS())};
+      switch (bin.getOp()) {
+      case ast::BinaryExpr::Op::Add:
+        return {IRBuilder.CreateFAdd(lhs.Value, rhs.Value),
+                add(lhs.Tangent, rhs.Tangent)};
+      case ast::BinaryExpr::Op::Sub:
+        return {IRBuilder.CreateFSub(lhs.Value, rhs.Value),
+                sub(lhs.Tangent, rhs.Tangent)};
+      case ast::BinaryExpr::Op::Mul:
+        // (uv)' = u'v + uv'
+        return {IRBuilder.CreateFMul(lhs.Value, rhs.Value),
+                add(scale(lhs.Tangent, rhs.Value),
+                    scale(rhs.Tangent, lhs.Value))};
+      case ast::BinaryExpr::Op::Div: {
+        // (u/v)' = (u' - (u/v)v') / v
+        llvm::Value *quotient{IRBuilder.CreateFDiv(lhs.Value, rhs.Value)};
+        return {quotient,
+                divide(sub(lhs.Tangent, scale(rhs.Tangent, quotient)),
+                       rhs.Value)};
+      }
+      case ast::BinaryExpr::Op::Assign:
+      case ast::BinaryExpr::Op::Less:
+      case ast::BinaryExpr::Op::LessEqual:
+      case ast::BinaryExpr::Op::Greater:
+      case ast::BinaryExpr::Op::GreaterEqual:
+      case ast::BinaryExpr::Op::Equal:
+      case ast::BinaryExpr::Op::NotEqual:
+        break;
+      }
+      MUA_COVERS_ALL_CASES;
+    }
+    case ast::Node::Kind::ConditionalExpr:
+      return lowerConditional(static_cast<const ast::ConditionalExpr &>(expr));
+    case ast::Node::Kind::ExprStmt:
+    case ast::Node::Kind::ReturnStmt:
+    case ast::Node::Kind::CompoundStmt:
+    case ast::Node::Kind::ForStmt:
+    case ast::Node::Kind::ParamDecl:
+    case ast::Node::Kind::FunctionDecl:
+    case ast::Node::Kind::TranslationUnit:
+      break;
+    }
+    MUA_COVERS_ALL_CASES;
+  }
+
+  void lowerStmt(const ast::Stmt &stmt) {
+    if (const auto *es{llvm::dyn_cast<ast::ExprStmt>(&stmt)}) {
+      lower(*es->getExpr());
+    } else {
+      lowerFor(llvm::cast<ast::ForStmt>(stmt));
+    }
+  }
+
+  /// Loops are lowered as in the function, with phis carrying both the value
+  /// and the tangent of the variables assigned in the body. The loop variable
+  /// differs from the start by a constant, so it has the same tangent
+  void lowerFor(const ast::ForStmt &fs) {
+    Dual start{lower(*fs.getStart())};
+    Dual end{lower(*fs.getEnd())};
+    const sema::Symbol *var{TheScope.lookup(fs.getVar())};
+    std::optional<Dual> outer;
+    if (auto it{Values.find(var)}; it != Values.end()) {
+      outer = it->second;
+    }
+    std::vector<const sema::Symbol *> assigned{
+        sema::GetAssignedVars(fs, TheScope)};
+    CountedLoop loop{IRBuilder, start.Value, end.Value};
+    for (const sema::Symbol *symbol : assigned) {
+      // Read before any assignment: the value is undefined
+      Dual initial{llvm::PoisonValue::get(FPTy), getZero(TangentTy)};
+      if (auto it{Values.find(symbol)}; it != Values.end()) {
+        initial = it->second;
+      }
+      Values[symbol] = {
+          loop.addCarried(initial.Value, symbol->getName()),
+          loop.addCarried(initial.Tangent, symbol->getName() + ".tangent")};
+    }
+    Values[var] = {
+        IRBuilder.CreateFAdd(start.Value,
+                             IRBuilder.CreateSIToFP(loop.getIndex(), FPTy),
+                             var->getName()),
+        start.Tangent};
+
+    for (const ast::StmtPtr &stmt : fs.getBody()->getStmts()) {
+      lowerStmt(*stmt);
+    }
+
+    std::vector<llvm::Value *> next;
+    for (const sema::Symbol *symbol : assigned) {
+      next.push_back(Values[symbol].Value);
+      next.push_back(Values[symbol].Tangent);
+    }
+    std::vector<llvm::Value *> exitValues{loop.close(next)};
+    for (std::size_t index{0}; index < assigned.size(); ++index) {
+      Values[assigned[index]] = {exitValues[2 * index],
+                                 exitValues[2 * index + 1]};
+    }
+    if (outer) {
+      Values[var] = *outer;
+    } else {
+      Values.erase(var);
+    }
+  }
+
+  llvm::Value *lowerComparison(const ast::BinaryExpr &bin) {
+    llvm::Value *lhs{lower(*bin.getLHS()).Value};
+    llvm::Value *rhs{lower(*bin.getRHS()).Value};
+    return IRBuilder.CreateFCmp(GetFCmpPredicate(bin.getOp()), lhs, rhs);
+  }
+
+  /// The tangent of a ConditionalExpr is the tangent of the branch taken, as
+  /// derivatives are not defined where the condition changes
+  Dual lowerConditional(const ast::ConditionalExpr &cond) {
+    llvm::Value *condition{nullptr};
+    if (const auto *bin{llvm::dyn_cast<ast::BinaryExpr>(cond.getCond())};
+        bin && ast::IsComparison(bin->getOp())) {
+      condition = lowerComparison(*bin);
+    } else {
+      condition = IRBuilder.CreateFCmpUNE(lower(*cond.getCond()).Value,
+                                          getZero(FPTy));
+    }
+    if (ShouldSelect(cond)) {
+      Dual thenDual{lower(*cond.getThen())};
+      Dual elseDual{lower(*cond.getElse())};
+      return {IRBuilder.CreateSelect(condition, thenDual.Value, elseDual.Value),
+              isZero(thenDual.Tangent) && isZero(elseDual.Tangent)
+                  ? getZero(TangentTy)
+                  : IRBuilder.CreateSelect(condition, thenDual.Tangent,
+                                           elseDual.Tangent)};
+    }
+
+    llvm::LLVMContext &context{Companion.getContext()};
+    auto *thenBlock{llvm::BasicBlock::Create(context, "if.then")};
+    auto *elseBlock{llvm::BasicBlock::Create(context, "if.else")};
+    auto *endBlock{llvm::BasicBlock::Create(context, "if.end")};
+    IRBuilder.CreateCondBr(condition, thenBlock, elseBlock);
+
+    thenBlock->insertInto(&Companion);
+    IRBuilder.SetInsertPoint(thenBlock);
+    Dual thenDual{lower(*cond.getThen())};
+    llvm::BasicBlock *thenEnd{IRBuilder.GetInsertBlock()};
+    IRBuilder.CreateBr(endBlock);
+
+    elseBlock->insertInto(&Companion);
+    IRBuilder.SetInsertPoint(elseBlock);
+    Dual elseDual{lower(*cond.getElse())};
+    llvm::BasicBlock *elseEnd{IRBuilder.GetInsertBlock()};
+    IRBuilder.CreateBr(endBlock);
+
+    endBlock->insertInto(&Companion);
+    IRBuilder.SetInsertPoint(endBlock);
+    auto join{[&](llvm::Value *thenValue, llvm::Value *elseValue) {
+      llvm::PHINode *phi{IRBuilder.CreatePHI(thenValue->getType(), 2)};
+      phi->addIncoming(thenValue, thenEnd);
+      phi->addIncoming(elseValue, elseEnd);
+      return phi;
+    }};
+    llvm::Value *value{join(thenDual.Value, elseDual.Value)};
+    if (isZero(thenDual.Tangent) && isZero(elseDual.Tangent)) {
+      return {value, getZero(TangentTy)};
+    }
+    return {value, join(thenDual.Tangent, elseDual.Tangent)};
+  }
+
+  /// Chain rule: the tangent of g(u1, ..., un) is the sum of the partial
+  /// derivatives of g, computed by its companion, scaled by the tangent of each
+  /// argument
+  Dual lowerCall(const ast::CallExpr &call) {
+    llvm::Module &module{*Companion.getParent()};
+    std::vector<Dual> args;
+    for (const ast::ExprPtr &arg : call.getArgs()) {
+      args.push_back(lower(*arg));
+    }
+    std::vector<llvm::Value *> values;
+    for (const Dual &arg : args) {
+      values.push_back(arg.Value);
+    }
+    if (const sema::Builtin *builtin{sema::LookupBuiltin(call.getCallee())}) {
+      return lowerBuiltin(*builtin, args, values);
+    }
+    // Companions rather than functions are called, even for values alone, so
+    // that values follow the semantics of companions whatever the model
+    llvm::Function *companion{module.getFunction(
+        (llvm::Twine{call.getCallee()} + sema::GradientSuffix).str())};
+    if (args.empty()) {
+      // Nothing is written through the array of a function without parameters
+      values.push_back(llvm::ConstantPointerNull::get(
+          llvm::PointerType::getUnqual(Companion.getContext())));
+      llvm::CallInst *result{IRBuilder.CreateCall(companion, values)};
+      result->setCallingConv(companion->getCallingConv());
+      return {result, getZero(TangentTy)};
+    }
+
+    auto *partialsTy{llvm::FixedVectorType::get(FPTy, args.size())};
+    // Allocas belong at the start of the entry block so they are promoted
+    llvm::IRBuilder<> entryBuilder{&Companion.getEntryBlock(),
+                                   Companion.getEntryBlock().begin()};
+    llvm::AllocaInst *partialsPtr{entryBuilder.CreateAlloca(partialsTy)};
+    values.push_back(partialsPtr);
+    llvm::CallInst *result{IRBuilder.CreateCall(companion, values)};
+    result->setCallingConv(companion->getCallingConv());
+    llvm::Value *partials{IRBuilder.CreateLoad(partialsTy, partialsPtr)};
+    llvm::Value *tangent{getZero(TangentTy)};
+    for (unsigned index{0}; index < args.size(); ++index) {
+      tangent = add(tangent,
+                    scale(args[index].Tangent,
+                          IRBuilder.CreateExtractElement(partials, index)));
+    }
+    return {result, tangent};
+  }
+
+  /// Builtins have no companion: the chain rule applies their partial
+  /// derivatives, known in closed form
+  Dual lowerBuiltin(const sema::Builtin &builtin, llvm::ArrayRef<Dual> args,
+                    llvm::ArrayRef<llvm::Value *> values) {
+    llvm::Value *result{IRBuilder.CreateIntrinsic(GetIntrinsic(builtin.TheID),
+                                                  {FPTy}, values)};
+    if (llvm::all_of(args,
+                     [](const Dual &arg) { return isZero(arg.Tangent); })) {
+      return {result, getZero(TangentTy)};
+    }
+    switch (builtin.TheID) {
+    case sema::Builtin::ID::Sqrt:
+      // sqrt(u)' = u' / 2sqrt(u)
+      return {result,
+              divide(args[0].Tangent, IRBuilder.CreateFAdd(result, result))};
+    case sema::Builtin::ID::Exp:
+      // exp(u)' = u'exp(u)
+      return {result, scale(args[0].Tangent, result)};
+    case sema::Builtin::ID::Log:
+      // log(u)' = u' / u
+      return {result, divide(args[0].Tangent, values[0])};
+    case sema::Builtin::ID::Pow: {
+      // pow(u, v)' = u'v pow(u, v - 1) + v' pow(u, v) log(u)
+      llvm::Value *tangent{getZero(TangentTy)};
+      if (!isZero(args[0].Tangent)) {
+        llvm::Value *power{IRBuilder.CreateIntrinsic(
+            llvm::Intrinsic::pow, {FPTy},
+            {values[0], IRBuilder.CreateFSub(
+                            values[1], llvm::ConstantFP::get(FPTy, 1))})};
+        tangent =
+            scale(args[0].Tangent, IRBuilder.CreateFMul(values[1], power));
+      }
+      if (!isZero(args[1].Tangent)) {
+        llvm::Value *logarithm{IRBuilder.CreateIntrinsic(
+            llvm::Intrinsic::log, {FPTy}, {values[0]})};
+        tangent = add(tangent, scale(args[1].Tangent,
+                                     IRBuilder.CreateFMul(result, logarithm)));
+      }
+      return {result, tangent};
+    }
+    case sema::Builtin::ID::Fma:
+      // fma(u, v, w)' = u'v + uv' + w'
+      return {result, add(add(scale(args[0].Tangent, values[1]),
+                              scale(args[1].Tangent, values[0])),
+                          args[2].Tangent)};
+    case sema::Builtin::ID::Min:
+    case sema::Builtin::ID::Max:
+      // The tangent of the argument selected, the first one on ties
+      return {result, IRBuilder.CreateSelect(
+                          IRBuilder.CreateFCmpOEQ(result, values[0]),
+                          args[0].Tangent, args[1].Tangent)};
+    case sema::Builtin::ID::Abs:
+      // abs(u)' = u' sign(u)
+      return {result,
+              scale(args[0].Tangent,
+                    IRBuilder.CreateIntrinsic(
+                        llvm::Intrinsic::copysign, {FPTy},
+                        {llvm::ConstantFP::get(FPTy, 1), values[0]}))};
+    }
+    MUA_COVERS_ALL_CASES;
+  }
+
+  const sema::Scope &TheScope;
+  llvm::Function &Companion;
+  llvm::IRBuilder<> IRBuilder;
+  /// Number of parameters of the function
+  unsigned Width;
+  /// Floating-point type of values and partial derivatives
+  llvm::Type *FPTy;
+  /// One lane per parameter. Functions without parameters still get one lane,
+  /// always zero, as vectors cannot be empty
+  llvm::FixedVectorType *TangentTy;
+  llvm::DenseMap<const sema::Symbol *, Dual> Values;
+};
+
+} // namespace
+
+void mua::lower::EmitGradients(const ast::TranslationUnit &tu,
+                               const sema::Scope &scope,
+                               const sema::CallGraph &callGraph,
+                               llvm::Module &module) {
+  // Declare every companion first, as companions call each other
+  std::vector<llvm::Function *> companions;
+  for (const ast::FunctionDeclPtr &fn : tu.getFNs()) {
+    const sema::Symbol *symbol{scope.lookup(fn->getName())};
+    llvm::Function *function{module.getFunction(symbol->getName())};
+    // Companions compute with the same precision as their function
+    llvm::Type *fpTy{function->getReturnType()};
+    std::vector<llvm::Type *> paramTys{function->arg_size(), fpTy};
+    paramTys.push_back(llvm::PointerType::getUnqual(module.getContext()));
+    llvm::Function *companion{llvm::Function::Create(
+        llvm::FunctionType::get(fpTy, paramTys, /*isVarArg=*/false),
+        function->getLinkage(),
+        llvm::Twine{symbol->getName()} + sema::GradientSuffix, module)};
+    companion->setCallingConv(function->getCallingConv());
+    // Companions only write the partial derivatives through their last
+    // parameter
+    companion->setOnlyAccessesArgMemory();
+    companion->setOnlyWritesMemory();
+    companion->setDoesNotThrow();
+    companion->addFnAttr(llvm::Attribute::NoSync);
+    companion->addParamAttr(function->arg_size(), llvm::Attribute::NoAlias);
+    companion->addParamAttr(function->arg_size(), llvm::Attribute::WriteOnly);
+    if (!callGraph.isRecursive(symbol)) {
+      companion->setDoesNotRecurse();
+    }
+    if (callGraph.isTerminating(symbol)) {
+      companion->setWillReturn();
+    }
+    companions.push_back(companion);
+  }
+
+  for (auto [fn, companion] : llvm::zip_equal(tu.getFNs(), companions)) {
+    const sema::Symbol *symbol{scope.lookup(fn->getName())};
+    GradientEmitter{*symbol->getScope(), *companion}.emit(*fn);
+    assert(!llvm::verifyFunction(*companion));
+  }
+}
@@ -0,0 +1,53 @@
+// MIT License
+//
+// Copyright (c) 2026-onwards Iñaki Amatria-Barral
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef MUA_LIB_LOWER_GRADIENT_H
+#define MUA_LIB_LOWER_GRADIENT_H
+
+namespace llvm {
+class Module;
+} // namespace llvm
+
+namespace mua::ast {
+struct TranslationUnit;
+} // namespace mua::ast
+
+namespace mua::sema {
+struct CallGraph;
+struct Scope;
+} // namespace mua::sema
+
+namespace mua::lower {
+
+/// Emit, for every function f of the TranslationUnit, a companion
+/// `T f_grad(T params..., ptr grad)`, with T the floating-point type of f,
+/// computing f and storing its partial derivatives with respect to each
+/// parameter through grad. Values are propagated in forward mode as dual
+/// numbers, whose tangents are vectors of one lane per parameter. Calls apply
+/// the chain rule through the companion of the callee, or through the partial
+/// derivatives of Builtins. Every function must already be in the Module
+void EmitGradients(const ast::TranslationUnit &, const sema::Scope &,
+                   const sema::CallGraph &, llvm::Module &);
+
+} // namespace mua::lower
+
+#endif // MUA_LIB_LOWER_GRADIENT_H
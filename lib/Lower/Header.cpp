@@ -0,0 +1,212 @@
+// MIT License
+//
+// Copyright (c) 2026-onwards Iñaki Amatria-Barral
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "mua/Lower/Lower.h"
+
+#include "mua/AST/TranslationUnit.h"
+#include "mua/Lower/IRUnit.h"
+#include "mua/Sema/Sema.h"
+#include "mua/Sema/Symbol.h"
+#include "mua/Support/ErrorHandling.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace mua;
+using namespace mua::lower;
+
+namespace {
+
+/// Keywords of C and C++, which may not name functions nor parameters in a
+/// header meant for both
+constexpr llvm::StringLiteral Keywords[]{
+    "_Alignas",         "_Alignof",     "_Atomic",
+    "_Bool",            "_Complex",     "_Generic",
+    "_Imaginary",       "_Noreturn",    "_Static_assert",
+    "_Thread_local",    "alignas",      "alignof",
+    "and",              "and_eq",       "asm",
+    "auto",             "bitand",       "bitor",
+    "bool",             "break",        "case",
+    "catch",            "char",         "char16_t",
+    "char32_t",         "char8_t",      "class",
+    "co_await",         "co_return",    "co_yield",
+    "compl",            "concept",      "const",
+    "const_cast",       "consteval",    "constexpr",
+    "constinit",        "continue",     "decltype",
+    "default",          "delete",       "do",
+    "double",           "dynamic_cast", "else",
+    "enum",             "explicit",     "export",
+    "extern",           "false",        "float",
+    "for",              "friend",       "goto",
+    "if",               "inline",       "int",
+    "long",             "mutable",      "namespace",
+    "new",              "noexcept",     "not",
+    "not_eq",           "nullptr",      "operator",
+    "or",               "or_eq",        "private",
+    "protected",        "public",       "register",
+    "reinterpret_cast", "requires",     "restrict",
+    "return",           "short",        "signed",
+    "sizeof",           "static",       "static_assert",
+    "static_cast",      "struct",       "switch",
+    "template",         "this",         "thread_local",
+    "throw",            "true",         "try",
+    "typedef",          "typeid",       "typename",
+    "union",            "unsigned",     "using",
+    "virtual",          "void",         "volatile",
+    "wchar_t",          "while",        "xor",
+    "xor_eq",
+};
+
+bool isKeyword(llvm::StringRef name) {
+  return llvm::is_contained(Keywords, name);
+}
+
+/// Name of a C parameter: mua names that are C keywords are suffixed with
+/// underscores, as are names already taken by other parameters
+std::string getParamName(llvm::StringRef name, llvm::StringSet<> &taken) {
+  std::string param{name.str()};
+  while (isKeyword(param) || taken.contains(param)) {
+    param += '_';
+  }
+  taken.insert(param);
+  return param;
+}
+
+/// Include guard of the header of a source file
+std::string getGuard(llvm::StringRef prefix, llvm::StringRef filename) {
+  std::string guard{"MUA_"};
+  for (char c : (prefix + llvm::sys::path::stem(filename)).str()) {
+    guard += llvm::isAlnum(c) ? llvm::toUpper(c) : '_';
+  }
+  return guard + "_H";
+}
+
+/// C type of the numbers of a precision
+llvm::StringRef getFPType(FPPrecision precision) {
+  switch (precision) {
+  case FPPrecision::F32:
+    return "float";
+  case FPPrecision::F64:
+    return "double";
+  }
+  MUA_COVERS_ALL_CASES;
+}
+
+/// Declare the entries of the dispatch table and its accessor. Entries are
+/// shared by every header of the same precision, so they are only defined once
+void writeDispatchTable(const llvm::Function &accessor, FPPrecision precision,
+                        llvm::StringRef prefix, llvm::raw_ostream &os) {
+  // Trampolines take and return numbers of the precision of the Module
+  llvm::StringRef fpTy{getFPType(precision)};
+  std::string entry{precision == FPPrecision::F32 ? "mua_function_f32"
+                                                  : "mua_function"};
+  std::string defined{llvm::StringRef{entry}.upper() + "_DEFINED"};
+  os << "\n#ifndef " << defined << "\n#define " << defined << '\n';
+  os << "/* Exported function: call evaluates it on its arity arguments */\n";
+  os << "struct " << entry << " {\n";
+  os << "  const char *name;\n";
+  os << "  uint64_t name_length;\n";
+  os << "  const void *function;\n";
+  os << "  " << fpTy << " (*call)(const " << fpTy << " *args);\n";
+  os << "  uint64_t arity;\n";
+  os << "};\n#endif\n";
+  os << "/* Exported function of the given name, or null */\n";
+  os << "const struct " << entry << " *" << prefix << accessor.getName()
+     << "(const char *name, uint64_t length);\n";
+}
+
+} // namespace
+
+bool mua::lower::WriteHeader(const IRUnit &theIRUnit,
+                             const ast::TranslationUnit &tu,
+                             const sema::Scope &scope,
+                             FPPrecision precision, llvm::StringRef prefix,
+                             llvm::raw_ostream &os, llvm::raw_ostream &errs) {
+  const llvm::Module &module{*theIRUnit.Module};
+  std::vector<const sema::Symbol *> exported;
+  for (const ast::FunctionDeclPtr &fn : tu.getFNs()) {
+    const sema::Symbol *symbol{scope.lookup(fn->getName())};
+    if (module.getFunction(symbol->getName())->hasLocalLinkage()) {
+      continue;
+    }
+    if (isKeyword((prefix + symbol->getName()).str())) {
+      errs << "error: function " << symbol->getName()
+           << " cannot be declared in C; use -symbol-prefix\n";
+      return false;
+    }
+    exported.push_back(symbol);
+  }
+
+  llvm::StringRef filename{module.getSourceFileName()};
+  std::string guard{getGuard(prefix, filename)};
+  os << "/* Functions exported by " << llvm::sys::path::filename(filename)
+     << " */\n\n";
+  os << "#ifndef " << guard << "\n#define " << guard << "\n\n";
+  const llvm::Function *accessor{module.getFunction(sema::DispatchAccessor)};
+  if (accessor) {
+    os << "#include <stdint.h>\n\n";
+  }
+  os << "#ifdef __cplusplus\nextern \"C\" {\n#endif\n";
+
+  llvm::StringRef fpTy{getFPType(precision)};
+  for (const sema::Symbol *symbol : exported) {
+    llvm::StringRef name{symbol->getName()};
+    llvm::StringSet<> taken;
+    std::vector<std::string> params;
+    for (const sema::Symbol *param :
+         symbol->getScope()->getSymbols(sema::Symbol::Kind::Param)) {
+      params.push_back(fpTy.str() + ' ' +
+                       getParamName(param->getName(), taken));
+    }
+
+    os << '\n' << fpTy << ' ' << prefix << name << '(';
+    if (params.empty()) {
+      os << "void";
+    }
+    llvm::interleaveComma(params, os);
+    os << ");\n";
+
+    std::string companion{(name + sema::GradientSuffix).str()};
+    if (!module.getFunction(companion)) {
+      continue;
+    }
+    std::string grad{getParamName("grad", taken)};
+    os << "/* Also stores the " << params.size()
+       << " partial derivatives of " << prefix << name << " through " << grad
+       << " */\n";
+    os << fpTy << ' ' << prefix << companion << '(';
+    for (const std::string &param : params) {
+      os << param << ", ";
+    }
+    os << fpTy << " *" << grad << ");\n";
+  }
+
+  if (accessor) {
+    writeDispatchTable(*accessor, precision, prefix, os);
+  }
+
+  os << "\n#ifdef __cplusplus\n}\n#endif\n\n#endif /* " << guard << " */\n";
+  return true;
+}
@@ -0,0 +1,72 @@
+// MIT License
+//
+// Copyright (c) 2026-onwards Iñaki Amatria-Barral
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "Intrinsics.h"
+
+#include "mua/Support/ErrorHandling.h"
+
+using namespace mua;
+using namespace mua::lower;
+
+llvm::Intrinsic::ID mua::lower::GetIntrinsic(sema::Builtin::ID id) {
+  switch (id) {
+  case sema::Builtin::ID::Sqrt:
+    return llvm::Intrinsic::sqrt;
+  case sema::Builtin::ID::Exp:
+    return llvm::Intrinsic::exp;
+  case sema::Builtin::ID::Log:
+    return llvm::Intrinsic::log;
+  case sema::Builtin::ID::Pow:
+    return llvm::Intrinsic::pow;
+  case sema::Builtin::ID::Fma:
+    return llvm::Intrinsic::fma;
+  case sema::Builtin::ID::Min:
+    return llvm::Intrinsic::minnum;
+  case sema::Builtin::ID::Max:
+    return llvm::Intrinsic::maxnum;
+  case sema::Builtin::ID::Abs:
+    return llvm::Intrinsic::fabs;
+  }
+  MUA_COVERS_ALL_CASES;
+}
+
+llvm::Intrinsic::ID mua::lower::GetConstrainedIntrinsic(sema::Builtin::ID id) {
+  switch (id) {
+  case sema::Builtin::ID::Sqrt:
+    return llvm::Intrinsic::experimental_constrained_sqrt;
+  case sema::Builtin::ID::Exp:
+    return llvm::Intrinsic::experimental_constrained_exp;
+  case sema::Builtin::ID::Log:
+    return llvm::Intrinsic::experimental_constrained_log;
+  case sema::Builtin::ID::Pow:
+    return llvm::Intrinsic::experimental_constrained_pow;
+  case sema::Builtin::ID::Fma:
+    return llvm::Intrinsic::experimental_constrained_fma;
+  case sema::Builtin::ID::Min:
+    return llvm::Intrinsic::experimental_constrained_minnum;
+  case sema::Builtin::ID::Max:
+    return llvm::Intrinsic::experimental_constrained_maxnum;
+  case sema::Builtin::ID::Abs:
+    return llvm::Intrinsic::not_intrinsic;
+  }
+  MUA_COVERS_ALL_CASES;
+}
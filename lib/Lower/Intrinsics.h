@@ -0,0 +1,41 @@
+// MIT License
+//
+// Copyright (c) 2026-onwards Iñaki Amatria-Barral
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef MUA_LIB_LOWER_INTRINSICS_H
+#define MUA_LIB_LOWER_INTRINSICS_H
+
+#include "mua/Sema/Builtin.h"
+#include "llvm/IR/Intrinsics.h"
+
+namespace mua::lower {
+
+/// LLVM intrinsic computing a Builtin, overloaded on the floating-point type
+llvm::Intrinsic::ID GetIntrinsic(sema::Builtin::ID);
+
+/// Constrained LLVM intrinsic computing a Builtin under the Strict model, or
+/// llvm::Intrinsic::not_intrinsic if the Builtin is exact and raises no
+/// floating-point exception, in which case GetIntrinsic may be used
+llvm::Intrinsic::ID GetConstrainedIntrinsic(sema::Builtin::ID);
+
+} // namespace mua::lower
+
+#endif // MUA_LIB_LOWER_INTRINSICS_H
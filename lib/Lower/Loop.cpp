@@ -0,0 +1,134 @@
+// MIT License
+//
+// Copyright (c) 2026-onwards Iñaki Amatria-Barral
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "Loop.h"
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/IR/Module.h"
+#include <cstdint>
+#include <limits>
+
+using namespace mua;
+using namespace mua::lower;
+
+namespace {
+
+llvm::Value *emitTripCount(llvm::IRBuilderBase &irBuilder, llvm::Value *start,
+                           llvm::Value *end) {
+  llvm::Type *i64Ty{irBuilder.getInt64Ty()};
+  if (start->getType()->isIntegerTy()) {
+    // Integer bounds are exactly representable, so nothing overflows
+    llvm::Value *count{irBuilder.CreateNSWAdd(
+        irBuilder.CreateNSWSub(end, start), irBuilder.getInt64(1))};
+    return irBuilder.CreateBinaryIntrinsic(llvm::Intrinsic::smax, count,
+                                           irBuilder.getInt64(0),
+                                           /*FMFSource=*/nullptr, "for.count");
+  }
+
+  llvm::Value *difference{irBuilder.CreateFSub(end, start)};
+  llvm::Type *fpTy{difference->getType()};
+  llvm::Value *count{nullptr};
+  if (irBuilder.getIsFPConstrained()) {
+    llvm::Module *module{irBuilder.GetInsertBlock()->getModule()};
+    auto getDeclaration{[&](llvm::Intrinsic::ID id) {
+      return llvm::Intrinsic::getOrInsertDeclaration(module, id, {fpTy});
+    }};
+    llvm::Value *floor{irBuilder.CreateConstrainedFPCall(
+        getDeclaration(llvm::Intrinsic::experimental_constrained_floor),
+        {difference})};
+    // fptosi.sat has no constrained form, and converting an out-of-range value
+    // would raise a spurious invalid exception, so the floor is clamped to
+    // [0, 2^62], where conversions are exact, first. Quiet NaNs clamp without
+    // raising exceptions, and negative or NaN differences are discarded below
+    llvm::Value *clamped{irBuilder.CreateConstrainedFPCall(
+        getDeclaration(llvm::Intrinsic::experimental_constrained_minnum),
+        {floor, llvm::ConstantFP::get(fpTy, 0x1p62)})};
+    clamped = irBuilder.CreateConstrainedFPCall(
+        getDeclaration(llvm::Intrinsic::experimental_constrained_maxnum),
+        {clamped, llvm::ConstantFP::get(fpTy, 0)});
+    count = irBuilder.CreateFPToSI(clamped, i64Ty);
+  } else {
+    // Huge differences saturate, so that adding one never overflows, and a NaN
+    // difference (of equal infinities) converts to zero
+    llvm::Value *floor{
+        irBuilder.CreateUnaryIntrinsic(llvm::Intrinsic::floor, difference)};
+    count = irBuilder.CreateIntrinsic(llvm::Intrinsic::fptosi_sat,
+                                      {i64Ty, fpTy}, {floor});
+  }
+  count = irBuilder.CreateBinaryIntrinsic(
+      llvm::Intrinsic::smin, count,
+      irBuilder.getInt64(std::numeric_limits<std::int64_t>::max() - 1));
+  count = irBuilder.CreateNSWAdd(count, irBuilder.getInt64(1));
+  // The loop does not run if end < start, nor if either bound is NaN
+  return irBuilder.CreateSelect(irBuilder.CreateFCmpOGE(end, start), count,
+                                irBuilder.getInt64(0), "for.count");
+}
+
+} // namespace
+
+CountedLoop::CountedLoop(llvm::IRBuilderBase &irBuilder, llvm::Value *start,
+                         llvm::Value *end)
+    : IRBuilder{irBuilder}, TripCount{emitTripCount(irBuilder, start, end)},
+      Guard{irBuilder.GetInsertBlock()} {
+  llvm::LLVMContext &context{IRBuilder.getContext()};
+  auto *body{
+      llvm::BasicBlock::Create(context, "for.body", Guard->getParent())};
+  Exit = llvm::BasicBlock::Create(context, "for.end");
+  IRBuilder.CreateCondBr(
+      IRBuilder.CreateICmpSGT(TripCount, IRBuilder.getInt64(0)), body, Exit);
+
+  IRBuilder.SetInsertPoint(body);
+  Index = IRBuilder.CreatePHI(IRBuilder.getInt64Ty(), 2, "for.index");
+  Index->addIncoming(IRBuilder.getInt64(0), Guard);
+}
+
+llvm::PHINode *CountedLoop::addCarried(llvm::Value *initial,
+                                       const llvm::Twine &name) {
+  llvm::PHINode *phi{IRBuilder.CreatePHI(initial->getType(), 2, name)};
+  phi->addIncoming(initial, Guard);
+  Carried.push_back(phi);
+  return phi;
+}
+
+std::vector<llvm::Value *>
+CountedLoop::close(llvm::ArrayRef<llvm::Value *> next) {
+  llvm::BasicBlock *latch{IRBuilder.GetInsertBlock()};
+  llvm::Value *nextIndex{IRBuilder.CreateAdd(Index, IRBuilder.getInt64(1),
+                                             "for.next", /*HasNUW=*/true,
+                                             /*HasNSW=*/true)};
+  Index->addIncoming(nextIndex, latch);
+  IRBuilder.CreateCondBr(IRBuilder.CreateICmpEQ(nextIndex, TripCount), Exit,
+                         Index->getParent());
+
+  Exit->insertInto(latch->getParent());
+  IRBuilder.SetInsertPoint(Exit);
+  std::vector<llvm::Value *> values;
+  for (auto [phi, value] : llvm::zip_equal(Carried, next)) {
+    phi->addIncoming(value, latch);
+    llvm::PHINode *exitPhi{
+        IRBuilder.CreatePHI(phi->getType(), 2, phi->getName())};
+    exitPhi->addIncoming(phi->getIncomingValue(0), Guard);
+    exitPhi->addIncoming(value, latch);
+    values.push_back(exitPhi);
+  }
+  return values;
+}
@@ -0,0 +1,66 @@
+// MIT License
+//
+// Copyright (c) 2026-onwards Iñaki Amatria-Barral
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef MUA_LIB_LOWER_LOOP_H
+#define MUA_LIB_LOWER_LOOP_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/IR/IRBuilder.h"
+#include <vector>
+
+namespace mua::lower {
+
+/// A loop running its body a number of times computed on entry, shaped as the
+/// loop vectorizer expects: a guard skips the loop when the trip count is zero,
+/// and a bottom-tested body counts an induction variable from 0 up to the trip
+/// count. The body may add blocks of its own
+struct CountedLoop final {
+  /// Emit the trip count of a loop from start to end, floor(end - start) + 1 if
+  /// end >= start and 0 otherwise, then the guard, and leave the builder at the
+  /// start of the body. Bounds are either both i64 or both floating-point
+  CountedLoop(llvm::IRBuilderBase &, llvm::Value *start, llvm::Value *end);
+
+  /// Induction variable, from 0 up to the trip count minus one
+  llvm::PHINode *getIndex() const { return Index; }
+
+  /// Add a value carried across iterations, given its value before the loop,
+  /// before emitting the body. Returns its value at the start of the body
+  llvm::PHINode *addCarried(llvm::Value *initial, const llvm::Twine &name);
+
+  /// Close the loop at the insertion point of the builder, given the value of
+  /// every carried value at the end of the body, and leave the builder after
+  /// the loop. Returns the value of every carried value there
+  std::vector<llvm::Value *> close(llvm::ArrayRef<llvm::Value *> next);
+
+private:
+  llvm::IRBuilderBase &IRBuilder;
+  llvm::Value *TripCount;
+  /// Block branching to the body, or past it if the trip count is zero
+  llvm::BasicBlock *Guard;
+  llvm::BasicBlock *Exit;
+  llvm::PHINode *Index;
+  std::vector<llvm::PHINode *> Carried;
+};
+
+} // namespace mua::lower
+
+#endif // MUA_LIB_LOWER_LOOP_H
@@ -22,13 +22,25 @@
 
 #include "mua/Lower/Lower.h"
 
+#include "Conditional.h"
+#include "Dispatch.h"
+#include "Gradient.h"
+#include "Intrinsics.h"
+#include "Loop.h"
+#include "ValueRange.h"
 #include "mua/AST/Walker.h"
 #include "mua/Lower/IRUnit.h"
+#include "mua/Sema/Annotation.h"
+#include "mua/Sema/Builtin.h"
+#include "mua/Sema/CallGraph.h"
+#include "mua/Sema/Sema.h"
 #include "mua/Sema/Symbol.h"
 #include "mua/Source/File.h"
 #include "mua/Support/ErrorHandling.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/Verifier.h"
+#include <optional>
 
 using namespace mua;
 using namespace mua::lower;
@@ -36,10 +48,24 @@ using namespace mua::lower;
 namespace {
 
 struct LowerToLLVMIRVisitor final {
-  LowerToLLVMIRVisitor(const sema::Scope &scope)
+  LowerToLLVMIRVisitor(const sema::Scope &scope, const Options &options)
       : LLVMContext{std::make_unique<llvm::LLVMContext>()},
         Module{std::make_unique<llvm::Module>("mua module", *LLVMContext)},
-        CurrentScope{&scope}, IRBuilder{*LLVMContext} {}
+        CurrentScope{&scope}, TheOptions{options}, IRBuilder{*LLVMContext} {
+    if (TheOptions.FloatingPoint == FPModel::Strict) {
+      IRBuilder.setIsFPConstrained(true);
+      IRBuilder.setDefaultConstrainedExcept(llvm::fp::ebStrict);
+      IRBuilder.setDefaultConstrainedRounding(llvm::RoundingMode::Dynamic);
+    }
+    llvm::FastMathFlags fastMathFlags;
+    if (TheOptions.FloatingPoint == FPModel::Fast) {
+      fastMathFlags.setFast();
+    }
+    if (TheOptions.Contraction == FPContract::Fast) {
+      fastMathFlags.setAllowContract();
+    }
+    IRBuilder.setFastMathFlags(fastMathFlags);
+  }
 
   template <typename T> bool onEnter(const T &) { return true; }
   template <typename T> void onExit(const T &) {}
@@ -50,36 +76,28 @@ struct LowerToLLVMIRVisitor final {
   }
 
   bool onEnter(const ast::ReturnStmt &rs) {
-    IRBuilder.CreateRet(lower(*rs.getValue()));
+    IRBuilder.CreateRet(toFP(lower(*rs.getValue())));
     return true;
   }
 
+  bool onEnter(const ast::ForStmt &fs) {
+    lowerFor(fs);
+    return false;
+  }
+
   bool onEnter(const ast::FunctionDecl &fn) {
     const sema::Symbol *symbol{CurrentScope->lookup(fn.getName())};
     const sema::Scope *scope{symbol->getScope()};
     std::vector<const sema::Symbol *> params{
         scope->getSymbols(sema::Symbol::Kind::Param)};
-    std::vector<llvm::Type *> paramTys{params.size(), IRBuilder.getDoubleTy()};
-    llvm::FunctionType *functionTy{
-        llvm::FunctionType::get(IRBuilder.getDoubleTy(), paramTys,
-                                /*isVarArg=*/false)};
-    llvm::Function *function{
-        llvm::Function::Create(functionTy, llvm::Function::ExternalLinkage,
-                               symbol->getName(), *Module)};
+    llvm::Function *function{Module->getFunction(symbol->getName())};
+    Ranges = AnalyzeValueRanges(fn, *scope, TheOptions.Precision);
     llvm::BasicBlock::Create(*LLVMContext,
                              /*Name=*/"", function);
     IRBuilder.SetInsertPoint(&function->getEntryBlock());
+    SymbolToValue.clear();
     for (auto [symbol, arg] : llvm::zip_equal(params, function->args())) {
-      llvm::AllocaInst *alloca{IRBuilder.CreateAlloca(
-          IRBuilder.getDoubleTy(), nullptr, symbol->getName())};
-      IRBuilder.CreateStore(&arg, alloca);
-      SymbolToValue[symbol] = alloca;
-    }
-    for (const sema::Symbol *symbol :
-         scope->getSymbols(sema::Symbol::Kind::Var)) {
-      llvm::AllocaInst *alloca{IRBuilder.CreateAlloca(
-          IRBuilder.getDoubleTy(), nullptr, symbol->getName())};
-      SymbolToValue[symbol] = alloca;
+      SymbolToValue[symbol] = &arg;
     }
     CurrentScope = scope;
     return true;
@@ -92,49 +110,495 @@ struct LowerToLLVMIRVisitor final {
 
   bool onEnter(const ast::TranslationUnit &tu) {
     Module->setSourceFileName(tu.getRange().getFile()->getFilename());
+    // Create every function up front so that calls may refer to functions
+    // defined later in the TranslationUnit
+    for (const ast::FunctionDeclPtr &fn : tu.getFNs()) {
+      const sema::Symbol *symbol{CurrentScope->lookup(fn->getName())};
+      std::vector<llvm::Type *> paramTys{
+          symbol->getScope()->getSymbols(sema::Symbol::Kind::Param).size(),
+          getFPTy()};
+      llvm::FunctionType *functionTy{
+          llvm::FunctionType::get(getFPTy(), paramTys, /*isVarArg=*/false)};
+      llvm::Function *function{
+          llvm::Function::Create(functionTy, llvm::Function::ExternalLinkage,
+                                 symbol->getName(), *Module)};
+      if (!isExported(tu, *fn)) {
+        function->setLinkage(llvm::Function::InternalLinkage);
+        function->setCallingConv(llvm::CallingConv::Fast);
+      }
+    }
+    TheCallGraph.emplace(tu, *CurrentScope);
+    inferAttributes(tu);
+    applyAnnotations(tu);
     return true;
   }
 
-  void onExit(const ast::TranslationUnit &) {
+  void onExit(const ast::TranslationUnit &tu) {
+    if (TheOptions.Gradients) {
+      EmitGradients(tu, *CurrentScope, *TheCallGraph, *Module);
+    }
+    if (TheOptions.DispatchTable) {
+      EmitDispatchTable(tu, *Module);
+    }
     assert(!llvm::verifyModule(*Module));
   }
 
   IRUnit takeIRUnit() { return {std::move(LLVMContext), std::move(Module)}; }
 
 private:
+  /// Functions are exported if listed in the Options or annotated @export. If
+  /// none is, every function is
+  bool isExported(const ast::TranslationUnit &tu,
+                  const ast::FunctionDecl &fn) const {
+    auto annotated{[](const ast::FunctionDeclPtr &fn) {
+      return sema::HasAnnotation(*fn, sema::Annotation::ID::Export);
+    }};
+    if (TheOptions.Exports.empty() && llvm::none_of(tu.getFNs(), annotated)) {
+      return true;
+    }
+    return llvm::is_contained(TheOptions.Exports,
+                              llvm::StringRef{fn.getName()}) ||
+           sema::HasAnnotation(fn, sema::Annotation::ID::Export);
+  }
+
+  /// Map the inlining and placement annotations of every function to LLVM
+  /// attributes. Hot and cold functions get the section prefixes profile-guided
+  /// optimization would give them, so that linkers group hot code into
+  /// .text.hot and cold code into .text.unlikely, and are moved to the start
+  /// and end of the Module for object formats without such grouping
+  void applyAnnotations(const ast::TranslationUnit &tu) {
+    llvm::Module::FunctionListType &functions{Module->getFunctionList()};
+    auto hotEnd{functions.begin()};
+    for (const ast::FunctionDeclPtr &fn : tu.getFNs()) {
+      llvm::Function *function{Module->getFunction(fn->getName())};
+      if (sema::HasAnnotation(*fn, sema::Annotation::ID::Inline)) {
+        function->addFnAttr(llvm::Attribute::AlwaysInline);
+      }
+      if (sema::HasAnnotation(*fn, sema::Annotation::ID::NoInline)) {
+        function->addFnAttr(llvm::Attribute::NoInline);
+      }
+      if (sema::HasAnnotation(*fn, sema::Annotation::ID::Hot)) {
+        function->addFnAttr(llvm::Attribute::Hot);
+        function->setSectionPrefix("hot");
+        if (function->getIterator() == hotEnd) {
+          ++hotEnd;
+        } else {
+          functions.splice(hotEnd, functions, function->getIterator());
+        }
+      }
+      if (sema::HasAnnotation(*fn, sema::Annotation::ID::Cold)) {
+        // As clang does for __attribute__((cold))
+        function->addFnAttr(llvm::Attribute::Cold);
+        function->addFnAttr(llvm::Attribute::OptimizeForSize);
+        function->setSectionPrefix("unlikely");
+        if (function->getIterator() == hotEnd) {
+          ++hotEnd;
+        }
+        functions.splice(functions.end(), functions, function->getIterator());
+      }
+    }
+  }
+
+  /// Functions only compute their result from their arguments, without side
+  /// effects (locals are SSA values), so they never access memory, unwind nor
+  /// synchronize. Functions whose calls are known to return have no undefined
+  /// behavior either, so they may be speculated. Under the Strict model,
+  /// raising floating-point exceptions is a side effect, so functions may only
+  /// access the floating-point environment and are never speculated
+  void inferAttributes(const ast::TranslationUnit &tu) {
+    const sema::CallGraph &callGraph{*TheCallGraph};
+    bool strict{TheOptions.FloatingPoint == FPModel::Strict};
+    for (const ast::FunctionDeclPtr &fn : tu.getFNs()) {
+      const sema::Symbol *symbol{CurrentScope->lookup(fn->getName())};
+      llvm::Function *function{Module->getFunction(symbol->getName())};
+      if (strict) {
+        function->addFnAttr(llvm::Attribute::StrictFP);
+        function->setOnlyAccessesInaccessibleMemory();
+      } else {
+        function->setDoesNotAccessMemory();
+      }
+      function->setDoesNotThrow();
+      function->addFnAttr(llvm::Attribute::NoSync);
+      if (!callGraph.isRecursive(symbol)) {
+        function->setDoesNotRecurse();
+      }
+      if (callGraph.isTerminating(symbol)) {
+        function->setWillReturn();
+        if (!strict) {
+          function->addFnAttr(llvm::Attribute::Speculatable);
+        }
+      }
+      if (TheOptions.FloatingPoint == FPModel::Fast) {
+        // Let the code generator use the same assumptions as the operations
+        for (llvm::StringRef kind :
+             {"approx-func-fp-math", "no-infs-fp-math", "no-nans-fp-math",
+              "no-signed-zeros-fp-math", "unsafe-fp-math"}) {
+          function->addFnAttr(kind, "true");
+        }
+      }
+    }
+  }
+
+  /// Fast-math flags of a floating-point operation computing an Expression
+  llvm::FastMathFlags getFastMathFlags(const ast::Expr &expr) {
+    // Bounded results have bounded operands, so neither is NaN nor infinite
+    return getFastMathFlags(Ranges.getRange(expr).isBounded());
+  }
+
+  /// Fast-math flags of a floating-point operation whose operands and result
+  /// may be known to be neither NaN nor infinite
+  llvm::FastMathFlags getFastMathFlags(bool bounded) {
+    llvm::FastMathFlags fastMathFlags{IRBuilder.getFastMathFlags()};
+    if (bounded) {
+      fastMathFlags.setNoNaNs();
+      fastMathFlags.setNoInfs();
+    }
+    return fastMathFlags;
+  }
+
+  /// The Expression as a floating-point multiplication, or nullptr
+  const ast::BinaryExpr *getFMul(const ast::Expr &expr) const {
+    const auto *mul{llvm::dyn_cast<ast::BinaryExpr>(&expr)};
+    if (!mul || mul->getOp() != ast::BinaryExpr::Op::Mul ||
+        Ranges.IntegerExprs.contains(mul)) {
+      return nullptr;
+    }
+    return mul;
+  }
+
+  /// Lower an addition or subtraction with a multiplication operand as a
+  /// single llvm.fmuladd, which the target may fuse into an FMA. Returns
+  /// nullptr if the Expression has no such form
+  llvm::Value *lowerMulAdd(const ast::BinaryExpr &bin) {
+    if (bin.getOp() != ast::BinaryExpr::Op::Add &&
+        bin.getOp() != ast::BinaryExpr::Op::Sub) {
+      return nullptr;
+    }
+    const ast::BinaryExpr *mul{getFMul(*bin.getLHS())};
+    bool mulFirst{mul != nullptr};
+    if (!mulFirst) {
+      mul = getFMul(*bin.getRHS());
+      if (!mul) {
+        return nullptr;
+      }
+    }
+
+    // Operands are evaluated in source order, as without contraction
+    llvm::Value *addend{nullptr};
+    if (!mulFirst) {
+      addend = toFP(lower(*bin.getLHS()));
+    }
+    llvm::Value *multiplier{toFP(lower(*mul->getLHS()))};
+    llvm::Value *multiplicand{toFP(lower(*mul->getRHS()))};
+    if (mulFirst) {
+      addend = toFP(lower(*bin.getRHS()));
+    }
+    // Negation is exact, so a*b-c and c-a*b are rounded once as well
+    if (bin.getOp() == ast::BinaryExpr::Op::Sub) {
+      if (mulFirst) {
+        addend = IRBuilder.CreateFNeg(addend);
+      } else {
+        multiplier = IRBuilder.CreateFNeg(multiplier);
+      }
+    }
+    llvm::IRBuilderBase::FastMathFlagGuard fastMathFlagGuard{IRBuilder};
+    IRBuilder.setFastMathFlags(getFastMathFlags(bin));
+    return IRBuilder.CreateIntrinsic(llvm::Intrinsic::fmuladd, {getFPTy()},
+                                     {multiplier, multiplicand, addend});
+  }
+
+  /// Lower a call to a Builtin as an LLVM intrinsic, which LLVM can
+  /// constant-fold, vectorize and select native instructions for
+  llvm::Value *lowerBuiltin(const sema::Builtin &builtin,
+                            const ast::CallExpr &call,
+                            llvm::ArrayRef<llvm::Value *> args) {
+    llvm::IRBuilderBase::FastMathFlagGuard fastMathFlagGuard{IRBuilder};
+    IRBuilder.setFastMathFlags(getFastMathFlags(call));
+    if (IRBuilder.getIsFPConstrained()) {
+      if (llvm::Intrinsic::ID id{GetConstrainedIntrinsic(builtin.TheID)};
+          id != llvm::Intrinsic::not_intrinsic) {
+        return IRBuilder.CreateConstrainedFPCall(
+            llvm::Intrinsic::getOrInsertDeclaration(Module.get(), id,
+                                                    {getFPTy()}),
+            args);
+      }
+    }
+    return IRBuilder.CreateIntrinsic(GetIntrinsic(builtin.TheID), {getFPTy()},
+                                     args);
+  }
+
+  /// Lower a comparison as an i1: an icmp if both operands are lowered as
+  /// i64, and an fcmp otherwise. Ordered comparisons other than == signal on
+  /// NaN operands, as in C
+  llvm::Value *lowerComparison(const ast::BinaryExpr &bin) {
+    llvm::Value *lhs{lower(*bin.getLHS())};
+    llvm::Value *rhs{lower(*bin.getRHS())};
+    if (lhs->getType()->isIntegerTy() && rhs->getType()->isIntegerTy()) {
+      return IRBuilder.CreateICmp(GetICmpPredicate(bin.getOp()), lhs, rhs);
+    }
+    lhs = toFP(lhs);
+    rhs = toFP(rhs);
+    llvm::IRBuilderBase::FastMathFlagGuard fastMathFlagGuard{IRBuilder};
+    // Comparisons are bounded even when their operands are not
+    IRBuilder.setFastMathFlags(
+        getFastMathFlags(Ranges.getRange(*bin.getLHS()).isBounded() &&
+                         Ranges.getRange(*bin.getRHS()).isBounded()));
+    llvm::CmpInst::Predicate predicate{GetFCmpPredicate(bin.getOp())};
+    if (bin.getOp() == ast::BinaryExpr::Op::Equal ||
+        bin.getOp() == ast::BinaryExpr::Op::NotEqual) {
+      return IRBuilder.CreateFCmp(predicate, lhs, rhs);
+    }
+    return IRBuilder.CreateFCmpS(predicate, lhs, rhs);
+  }
+
+  /// Lower the condition of a ConditionalExpr as an i1, true if it is not
+  /// zero. NaN is not zero
+  llvm::Value *lowerCondition(const ast::Expr &expr) {
+    if (const auto *bin{llvm::dyn_cast<ast::BinaryExpr>(&expr)};
+        bin && ast::IsComparison(bin->getOp())) {
+      return lowerComparison(*bin);
+    }
+    llvm::Value *value{lower(expr)};
+    if (value->getType()->isIntegerTy()) {
+      return IRBuilder.CreateICmpNE(value, IRBuilder.getInt64(0));
+    }
+    return IRBuilder.CreateFCmpUNE(value, llvm::ConstantFP::get(getFPTy(), 0));
+  }
+
+  /// Lower a ConditionalExpr as a select of both branches if they are cheap
+  /// and may be evaluated speculatively (see ShouldSelect), and as a
+  /// conditional branch and a phi otherwise. Under the Strict model, only the
+  /// branch taken may raise floating-point exceptions, so it is always a
+  /// conditional branch
+  llvm::Value *lowerConditional(const ast::ConditionalExpr &cond) {
+    bool integer{Ranges.IntegerExprs.contains(&cond)};
+    auto lowerBranch{[&](const ast::Expr &expr) {
+      llvm::Value *value{lower(expr)};
+      return integer ? value : toFP(value);
+    }};
+    llvm::Value *condition{lowerCondition(*cond.getCond())};
+    if (!IRBuilder.getIsFPConstrained() && ShouldSelect(cond)) {
+      llvm::Value *thenValue{lowerBranch(*cond.getThen())};
+      llvm::Value *elseValue{lowerBranch(*cond.getElse())};
+      return IRBuilder.CreateSelect(condition, thenValue, elseValue);
+    }
+
+    llvm::Function *function{IRBuilder.GetInsertBlock()->getParent()};
+    auto *thenBlock{llvm::BasicBlock::Create(*LLVMContext, "if.then")};
+    auto *elseBlock{llvm::BasicBlock::Create(*LLVMContext, "if.else")};
+    auto *endBlock{llvm::BasicBlock::Create(*LLVMContext, "if.end")};
+    IRBuilder.CreateCondBr(condition, thenBlock, elseBlock);
+
+    // Blocks are inserted once reached, so that they are laid out in source
+    // order even when branches nest ConditionalExprs
+    thenBlock->insertInto(function);
+    IRBuilder.SetInsertPoint(thenBlock);
+    llvm::Value *thenValue{lowerBranch(*cond.getThen())};
+    llvm::BasicBlock *thenEnd{IRBuilder.GetInsertBlock()};
+    IRBuilder.CreateBr(endBlock);
+
+    elseBlock->insertInto(function);
+    IRBuilder.SetInsertPoint(elseBlock);
+    llvm::Value *elseValue{lowerBranch(*cond.getElse())};
+    llvm::BasicBlock *elseEnd{IRBuilder.GetInsertBlock()};
+    IRBuilder.CreateBr(endBlock);
+
+    endBlock->insertInto(function);
+    IRBuilder.SetInsertPoint(endBlock);
+    llvm::PHINode *phi{IRBuilder.CreatePHI(thenValue->getType(), 2)};
+    phi->addIncoming(thenValue, thenEnd);
+    phi->addIncoming(elseValue, elseEnd);
+    return phi;
+  }
+
+  /// Lower a Statement of a loop body, which the walk does not visit
+  void lowerStmt(const ast::Stmt &stmt) {
+    if (const auto *es{llvm::dyn_cast<ast::ExprStmt>(&stmt)}) {
+      lower(*es->getExpr());
+    } else {
+      lowerFor(llvm::cast<ast::ForStmt>(stmt));
+    }
+  }
+
+  /// Lower a ForStmt as a CountedLoop. The variables assigned in the body are
+  /// carried across iterations by phis and the loop variable is derived from
+  /// the induction variable, so the loop vectorizer recognizes reductions and
+  /// inductions. Floating-point reductions are only vectorized under the Fast
+  /// model, which allows reassociating them
+  void lowerFor(const ast::ForStmt &fs) {
+    llvm::Value *start{lower(*fs.getStart())};
+    llvm::Value *end{lower(*fs.getEnd())};
+    bool integer{start->getType()->isIntegerTy() &&
+                 end->getType()->isIntegerTy()};
+    if (!integer) {
+      start = toFP(start);
+      end = toFP(end);
+    }
+
+    const sema::Symbol *var{CurrentScope->lookup(fs.getVar())};
+    llvm::Value *outer{SymbolToValue.lookup(var)};
+    std::vector<const sema::Symbol *> assigned{
+        sema::GetAssignedVars(fs, *CurrentScope)};
+    CountedLoop loop{IRBuilder, start, end};
+    for (const sema::Symbol *symbol : assigned) {
+      llvm::Value *initial{SymbolToValue.lookup(symbol)};
+      if (!initial) {
+        // Read before any assignment: the value is undefined
+        initial = llvm::PoisonValue::get(getType(symbol));
+      }
+      SymbolToValue[symbol] = loop.addCarried(initial, symbol->getName());
+    }
+
+    llvm::Value *value{nullptr};
+    if (integer) {
+      value = IRBuilder.CreateNSWAdd(start, loop.getIndex());
+      if (getType(var)->isFloatingPointTy()) {
+        value = toFP(value);
+      }
+    } else {
+      llvm::IRBuilderBase::FastMathFlagGuard fastMathFlagGuard{IRBuilder};
+      IRBuilder.setFastMathFlags(
+          getFastMathFlags(Ranges.getRange(*fs.getStart()).isBounded()));
+      value = IRBuilder.CreateFAdd(
+          start, IRBuilder.CreateSIToFP(loop.getIndex(), getFPTy()));
+    }
+    value->setName(var->getName());
+    SymbolToValue[var] = value;
+
+    for (const ast::StmtPtr &stmt : fs.getBody()->getStmts()) {
+      lowerStmt(*stmt);
+    }
+
+    std::vector<llvm::Value *> next;
+    for (const sema::Symbol *symbol : assigned) {
+      next.push_back(SymbolToValue[symbol]);
+    }
+    std::vector<llvm::Value *> exitValues{loop.close(next)};
+    for (auto [symbol, exitValue] : llvm::zip_equal(assigned, exitValues)) {
+      SymbolToValue[symbol] = exitValue;
+    }
+    if (outer) {
+      SymbolToValue[var] = outer;
+    } else {
+      SymbolToValue.erase(var);
+    }
+  }
+
+  /// Floating-point type of numbers
+  llvm::Type *getFPTy() {
+    return TheOptions.Precision == FPPrecision::F32 ? IRBuilder.getFloatTy()
+                                                    : IRBuilder.getDoubleTy();
+  }
+
+  /// Type of the values of a Param or Var symbol
+  llvm::Type *getType(const sema::Symbol *symbol) {
+    return Ranges.IntegerVars.contains(symbol) ? IRBuilder.getInt64Ty()
+                                               : getFPTy();
+  }
+
+  /// Convert a lowered value to the floating-point type of numbers, the type of
+  /// every value crossing a function boundary
+  llvm::Value *toFP(llvm::Value *value) {
+    if (value->getType()->isIntegerTy()) {
+      return IRBuilder.CreateSIToFP(value, getFPTy());
+    }
+    return value;
+  }
+
+  /// Lower an Expression. Expressions selected by the value-range analysis are
+  /// lowered as i64, all others as floating-point numbers
   llvm::Value *lower(const ast::Expr &expr) {
     switch (expr.getKind()) {
     case ast::Node::Kind::NumberExpr: {
       const auto &ne{static_cast<const ast::NumberExpr &>(expr)};
-      return llvm::ConstantFP::get(IRBuilder.getDoubleTy(), ne.getValue());
+      if (Ranges.IntegerExprs.contains(&expr)) {
+        return IRBuilder.getInt64(static_cast<std::int64_t>(
+            Round(ne.getValue(), TheOptions.Precision)));
+      }
+      return llvm::ConstantFP::get(getFPTy(), ne.getValue());
     }
     case ast::Node::Kind::IdentifierExpr: {
       const auto &id{static_cast<const ast::IdentifierExpr &>(expr)};
       const sema::Symbol *symbol{CurrentScope->lookup(id.getName())};
-      return IRBuilder.CreateLoad(IRBuilder.getDoubleTy(),
-                                  SymbolToValue.at(symbol), symbol->getName());
+      if (llvm::Value *value{SymbolToValue.lookup(symbol)}) {
+        return value;
+      }
+      // Read before any assignment: the value is undefined
+      return llvm::PoisonValue::get(getType(symbol));
     }
     case ast::Node::Kind::CallExpr: {
       const auto &call{static_cast<const ast::CallExpr &>(expr)};
-      llvm::Function *function{Module->getFunction(call.getCallee())};
       std::vector<llvm::Value *> args;
       for (const ast::ExprPtr &arg : call.getArgs()) {
-        args.push_back(lower(*arg));
+        args.push_back(toFP(lower(*arg)));
       }
-      return IRBuilder.CreateCall(function, args);
+      if (const sema::Builtin *builtin{
+              sema::LookupBuiltin(call.getCallee())}) {
+        return lowerBuiltin(*builtin, call, args);
+      }
+      llvm::Function *function{Module->getFunction(call.getCallee())};
+      llvm::CallInst *callInst{IRBuilder.CreateCall(function, args)};
+      callInst->setCallingConv(function->getCallingConv());
+      return callInst;
     }
     case ast::Node::Kind::BinaryExpr: {
       const auto &bin{static_cast<const ast::BinaryExpr &>(expr)};
       if (bin.getOp() == ast::BinaryExpr::Op::Assign) {
         const auto &id{static_cast<const ast::IdentifierExpr &>(*bin.getLHS())};
         const sema::Symbol *symbol{CurrentScope->lookup(id.getName())};
-        llvm::Value *lhs{SymbolToValue.at(symbol)};
         llvm::Value *rhs{lower(*bin.getRHS())};
-        IRBuilder.CreateStore(rhs, lhs);
+        if (getType(symbol)->isFloatingPointTy()) {
+          rhs = toFP(rhs);
+        }
+        if (auto *inst{llvm::dyn_cast<llvm::Instruction>(rhs)};
+            inst && !inst->hasName()) {
+          inst->setName(symbol->getName());
+        }
+        SymbolToValue[symbol] = rhs;
         return rhs;
       }
+      if (ast::IsComparison(bin.getOp())) {
+        llvm::Value *comparison{lowerComparison(bin)};
+        if (Ranges.IntegerExprs.contains(&expr)) {
+          return IRBuilder.CreateZExt(comparison, IRBuilder.getInt64Ty());
+        }
+        return IRBuilder.CreateUIToFP(comparison, getFPTy());
+      }
+      if (TheOptions.Contraction == FPContract::On &&
+          !Ranges.IntegerExprs.contains(&expr)) {
+        if (llvm::Value *mulAdd{lowerMulAdd(bin)}) {
+          return mulAdd;
+        }
+      }
       llvm::Value *lhs{lower(*bin.getLHS())};
       llvm::Value *rhs{lower(*bin.getRHS())};
+      if (Ranges.IntegerExprs.contains(&expr)) {
+        // The result is an exactly representable integer, so integer
+        // arithmetic neither overflows nor rounds
+        switch (bin.getOp()) {
+        case ast::BinaryExpr::Op::Add:
+          return IRBuilder.CreateNSWAdd(lhs, rhs);
+        case ast::BinaryExpr::Op::Sub:
+          return IRBuilder.CreateNSWSub(lhs, rhs);
+        case ast::BinaryExpr::Op::Mul:
+          return IRBuilder.CreateNSWMul(lhs, rhs);
+        case ast::BinaryExpr::Op::Div:
+          return IRBuilder.CreateExactSDiv(lhs, rhs);
+        case ast::BinaryExpr::Op::Assign:
+        case ast::BinaryExpr::Op::Less:
+        case ast::BinaryExpr::Op::LessEqual:
+        case ast::BinaryExpr::Op::Greater:
+        case ast::BinaryExpr::Op::GreaterEqual:
+        case ast::BinaryExpr::Op::Equal:
+        case ast::BinaryExpr::Op::NotEqual:
+          break;
+        }
+        MUA_COVERS_ALL_CASES;
+      }
+      lhs = toFP(lhs);
+      rhs = toFP(rhs);
+      llvm::IRBuilderBase::FastMathFlagGuard fastMathFlagGuard{IRBuilder};
+      IRBuilder.setFastMathFlags(getFastMathFlags(expr));
       switch (bin.getOp()) {
       case ast::BinaryExpr::Op::Add:
         return IRBuilder.CreateFAdd(lhs, rhs);
@@ -145,13 +609,22 @@ private:
       case ast::BinaryExpr::Op::Div:
         return IRBuilder.CreateFDiv(lhs, rhs);
       case ast::BinaryExpr::Op::Assign:
+      case ast::BinaryExpr::Op::Less:
+      case ast::BinaryExpr::Op::LessEqual:
+      case ast::BinaryExpr::Op::Greater:
+      case ast::BinaryExpr::Op::GreaterEqual:
+      case ast::BinaryExpr::Op::Equal:
+      case ast::BinaryExpr::Op::NotEqual:
         break;
       }
       MUA_COVERS_ALL_CASES;
     }
+    case ast::Node::Kind::ConditionalExpr:
+      return lowerConditional(static_cast<const ast::ConditionalExpr &>(expr));
     case ast::Node::Kind::ExprStmt:
     case ast::Node::Kind::ReturnStmt:
     case ast::Node::Kind::CompoundStmt:
+    case ast::Node::Kind::ForStmt:
     case ast::Node::Kind::ParamDecl:
     case ast::Node::Kind::FunctionDecl:
     case ast::Node::Kind::TranslationUnit:
@@ -164,16 +637,25 @@ private:
   std::unique_ptr<llvm::Module> Module;
 
   const sema::Scope *CurrentScope;
+  const Options &TheOptions;
+  std::optional<sema::CallGraph> TheCallGraph;
 
   llvm::IRBuilder<> IRBuilder;
+  /// Current value of each Param and Var of the function being lowered.
+  /// Variables are never assigned in the branches of a ConditionalExpr, so
+  /// values are SSA from the start: only loops need phis, and no memory is
+  /// needed
   llvm::DenseMap<const sema::Symbol *, llvm::Value *> SymbolToValue;
+  /// Value ranges of the function being lowered
+  ValueRanges Ranges;
 };
 
 } // namespace
 
 IRUnit mua::lower::LowerToLLVMIR(const ast::TranslationUnit &tu,
-                                 const sema::Scope &scope) {
-  LowerToLLVMIRVisitor lowerToLLVMIRVisitor{scope};
+                                 const sema::Scope &scope,
+                                 const Options &options) {
+  LowerToLLVMIRVisitor lowerToLLVMIRVisitor{scope, options};
   ast::Walk(tu, lowerToLLVMIRVisitor);
   return lowerToLLVMIRVisitor.takeIRUnit();
 }
@@ -181,3 +663,28 @@ IRUnit mua::lower::LowerToLLVMIR(const ast::TranslationUnit &tu,
 void mua::lower::Dump(const IRUnit &theIRUnit, llvm::raw_ostream &os) {
   theIRUnit.Module->print(os, /*AAW=*/nullptr);
 }
+
+void mua::lower::WriteBitcode(const IRUnit &theIRUnit, llvm::raw_ostream &os) {
+  llvm::WriteBitcodeToFile(*theIRUnit.Module, os);
+}
+
+void mua::lower::PrefixSymbols(IRUnit &theIRUnit, llvm::StringRef prefix) {
+  llvm::Module &module{*theIRUnit.Module};
+  // Release every exported name first, so that prefixed names never clash with
+  // names not prefixed yet
+  std::vector<std::pair<llvm::GlobalValue *, std::string>> exported;
+  for (llvm::GlobalValue &global : module.global_values()) {
+    if (!global.isDeclaration() && !global.hasLocalLinkage()) {
+      exported.emplace_back(&global, (prefix + global.getName()).str());
+      global.setName("");
+    }
+  }
+  for (auto &[global, name] : exported) {
+    // Local symbols are only named for readability, so they make way
+    if (llvm::GlobalValue *other{module.getNamedValue(name)};
+        other && other->hasLocalLinkage()) {
+      other->setName(name + ".local");
+    }
+    global->setName(name);
+  }
+}
@@ -0,0 +1,166 @@
+// MIT License
+//
+// Copyright (c) 2026-onwards Iñaki Amatria-Barral
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "mua/Lower/IRUnit.h"
+#include "mua/Lower/Lower.h"
+#include "mua/Support/ErrorHandling.h"
+#include "llvm/Passes/PassBuilder.h"
+
+using namespace mua;
+using namespace mua::lower;
+
+static llvm::OptimizationLevel GetLLVMOptLevel(OptLevel level) {
+  switch (level) {
+  case OptLevel::O0:
+    return llvm::OptimizationLevel::O0;
+  case OptLevel::O1:
+    return llvm::OptimizationLevel::O1;
+  case OptLevel::O2:
+    return llvm::OptimizationLevel::O2;
+  case OptLevel::O3:
+    return llvm::OptimizationLevel::O3;
+  case OptLevel::Os:
+    return llvm::OptimizationLevel::Os;
+  }
+  MUA_COVERS_ALL_CASES;
+}
+
+void mua::lower::Optimize(IRUnit &theIRUnit, OptLevel level,
+                          llvm::TargetMachine *targetMachine) {
+  // Functions annotated @inline are inlined even at O0, as in C
+  if (level == OptLevel::O0 &&
+      llvm::none_of(*theIRUnit.Module, [](const llvm::Function &function) {
+        return function.hasFnAttribute(llvm::Attribute::AlwaysInline);
+      })) {
+    return;
+  }
+
+  llvm::LoopAnalysisManager loopAM;
+  llvm::FunctionAnalysisManager functionAM;
+  llvm::CGSCCAnalysisManager cgsccAM;
+  llvm::ModuleAnalysisManager moduleAM;
+
+  // The pipeline leaves vectorization to its users, which enable it from -O2,
+  // as clang does
+  llvm::PipelineTuningOptions tuningOptions;
+  bool vectorize{level == OptLevel::O2 || level == OptLevel::O3 ||
+                 level == OptLevel::Os};
+  tuningOptions.LoopVectorization = vectorize;
+  tuningOptions.SLPVectorization = vectorize;
+
+  llvm::PassBuilder passBuilder{targetMachine, tuningOptions};
+  passBuilder.registerModuleAnalyses(moduleAM);
+  passBuilder.registerCGSCCAnalyses(cgsccAM);
+  passBuilder.registerFunctionAnalyses(functionAM);
+  passBuilder.registerLoopAnalyses(loopAM);
+  passBuilder.crossRegisterProxies(loopAM, functionAM, cgsccAM, moduleAM);
+
+  llvm::ModulePassManager modulePM{
+      level == OptLevel::O0
+          ? passBuilder.buildO0DefaultPipeline(llvm::OptimizationLevel::O0)
+          : passBuilder.buildPerModuleDefaultPipeline(GetLLVMOptLevel(level))};
+  modulePM.run(*theIRUnit.Module, moduleAM);
+}
+
+void mua::lower::Optimize(IRUnit &theIRUnit,
+                          llvm::ArrayRef<FunctionOptLevel> levels,
+                          llvm::TargetMachine *targetMachine) {
+  llvm::Module &module{*theIRUnit.Module};
+  // optnone requires noinline, which in turn excludes alwaysinline: @inline
+  // functions are optimized wherever they are inlined
+  auto exclude{[](llvm::Function &function) {
+    function.addFnAttr(llvm::Attribute::OptimizeNone);
+    function.addFnAttr(llvm::Attribute::NoInline);
+  }};
+  auto excludable{[&](llvm::StringRef name) -> llvm::Function * {
+    llvm::Function *function{module.getFunction(name)};
+    if (!function || function->hasFnAttribute(llvm::Attribute::AlwaysInline)) {
+      return nullptr;
+    }
+    return function;
+  }};
+
+  for (const FunctionOptLevel &level : levels) {
+    if (level.Level != OptLevel::O0) {
+      continue;
+    }
+    if (llvm::Function *function{excludable(level.Name)}) {
+      exclude(*function);
+    }
+  }
+  // Functions without a level, such as gradient companions and the dispatch
+  // table, are only optimized by the first pipeline to run
+  std::vector<std::string> unplanned;
+  for (const llvm::Function &function : module) {
+    if (!function.isDeclaration() &&
+        llvm::none_of(levels, [&](const FunctionOptLevel &level) {
+          return level.Name == function.getName();
+        })) {
+      unplanned.push_back(function.getName().str());
+    }
+  }
+
+  // Each other level runs in turn, with the functions of other levels
+  // temporarily excluded like O0 ones
+  bool optimized{false};
+  for (OptLevel pipeline : {OptLevel::O1, OptLevel::O2, OptLevel::O3,
+                            OptLevel::Os}) {
+    if (llvm::none_of(levels, [&](const FunctionOptLevel &level) {
+          return level.Level == pipeline;
+        })) {
+      continue;
+    }
+    std::vector<llvm::StringRef> names;
+    for (const FunctionOptLevel &level : levels) {
+      if (level.Level != OptLevel::O0 && level.Level != pipeline) {
+        names.push_back(level.Name);
+      }
+    }
+    if (optimized) {
+      llvm::append_range(names, unplanned);
+    }
+    // Names, and whether they were noinline already, as functions may be
+    // removed by the pipeline
+    std::vector<std::pair<llvm::StringRef, bool>> excluded;
+    for (llvm::StringRef name : names) {
+      if (llvm::Function *function{excludable(name)}) {
+        excluded.emplace_back(
+            name, function->hasFnAttribute(llvm::Attribute::NoInline));
+        exclude(*function);
+      }
+    }
+    Optimize(theIRUnit, pipeline, targetMachine);
+    optimized = true;
+    for (auto [name, noInline] : excluded) {
+      if (llvm::Function *function{module.getFunction(name)}) {
+        function->removeFnAttr(llvm::Attribute::OptimizeNone);
+        if (!noInline) {
+          function->removeFnAttr(llvm::Attribute::NoInline);
+        }
+      }
+    }
+  }
+  // If every function is at O0, @inline is still honored
+  if (!optimized) {
+    Optimize(theIRUnit, OptLevel::O0, targetMachine);
+  }
+}
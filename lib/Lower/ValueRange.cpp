@@ -0,0 +1,401 @@
+// MIT License
+//
+// Copyright (c) 2026-onwards Iñaki Amatria-Barral
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "ValueRange.h"
+
+#include "mua/AST/Decl.h"
+#include "mua/Sema/Sema.h"
+#include "mua/Sema/Symbol.h"
+#include "mua/Support/ErrorHandling.h"
+#include "llvm/Support/Casting.h"
+#include <algorithm>
+#include <cmath>
+#include <optional>
+
+using namespace mua;
+using namespace mua::lower;
+
+namespace {
+
+/// Every integer of smaller magnitude is exactly representable as a float
+constexpr double MaxExactFloatInteger{16777216.0}; // 2^24
+/// Every integer of smaller magnitude is exactly representable as a double
+constexpr double MaxExactDoubleInteger{9007199254740992.0}; // 2^53
+
+/// Whether the product or quotient of two values may be negative (and so may
+/// be -0.0 when it underflows or one of the factors is zero)
+bool signsMayDiffer(double lhsLo, double lhsHi, double rhsLo, double rhsHi) {
+  return (lhsLo < 0 && rhsHi >= 0) || (lhsHi >= 0 && rhsLo < 0);
+}
+
+} // namespace
+
+// Bounds are computed with the same (round to nearest) arithmetic as the values
+// they bound. As rounding is monotonic, they are exact bounds of the results.
+// Float bounds are computed as doubles and then rounded, which gives the same
+// results as float arithmetic because a double has more than twice the digits
+
+ValueRange::ValueRange(double lo, double hi, bool integral, bool negativeZero,
+                       FPPrecision precision)
+    : Lo{Round(lo, precision)}, Hi{Round(hi, precision)},
+      Bounded{std::isfinite(Lo) && std::isfinite(Hi)}, Integral{integral},
+      NegativeZero{negativeZero}, Precision{precision} {}
+
+ValueRange ValueRange::Constant(double value, FPPrecision precision) {
+  value = Round(value, precision);
+  return {value, value, value == std::trunc(value),
+          value == 0 && std::signbit(value), precision};
+}
+
+ValueRange ValueRange::Add(ValueRange lhs, ValueRange rhs) {
+  if (!lhs.Bounded || !rhs.Bounded) {
+    return {};
+  }
+  return {lhs.Lo + rhs.Lo, lhs.Hi + rhs.Hi, lhs.Integral && rhs.Integral,
+          lhs.NegativeZero && rhs.NegativeZero, lhs.Precision};
+}
+
+ValueRange ValueRange::Sub(ValueRange lhs, ValueRange rhs) {
+  if (!lhs.Bounded || !rhs.Bounded) {
+    return {};
+  }
+  return {lhs.Lo - rhs.Hi, lhs.Hi - rhs.Lo, lhs.Integral && rhs.Integral,
+          lhs.NegativeZero && rhs.contains(0), lhs.Precision};
+}
+
+ValueRange ValueRange::Mul(ValueRange lhs, ValueRange rhs) {
+  if (!lhs.Bounded || !rhs.Bounded) {
+    return {};
+  }
+  std::initializer_list<double> corners{lhs.Lo * rhs.Lo, lhs.Lo * rhs.Hi,
+                                        lhs.Hi * rhs.Lo, lhs.Hi * rhs.Hi};
+  bool integral{lhs.Integral && rhs.Integral};
+  // Products of integers only underflow to zero when a factor is zero
+  bool negativeZero{
+      lhs.NegativeZero || rhs.NegativeZero ||
+      (integral ? (lhs.contains(0) && rhs.Lo < 0) ||
+                      (rhs.contains(0) && lhs.Lo < 0)
+                : signsMayDiffer(lhs.Lo, lhs.Hi, rhs.Lo, rhs.Hi))};
+  return {std::min(corners), std::max(corners), integral, negativeZero,
+          lhs.Precision};
+}
+
+ValueRange ValueRange::Div(ValueRange lhs, ValueRange rhs) {
+  if (!lhs.Bounded || !rhs.Bounded || rhs.contains(0)) {
+    return {};
+  }
+  std::initializer_list<double> corners{lhs.Lo / rhs.Lo, lhs.Lo / rhs.Hi,
+                                        lhs.Hi / rhs.Lo, lhs.Hi / rhs.Hi};
+  // Only exact quotients of known integers are known to be integers
+  bool integral{lhs.Integral && rhs.Integral && lhs.Lo == lhs.Hi &&
+                rhs.Lo == rhs.Hi && std::fmod(lhs.Lo, rhs.Lo) == 0};
+  bool negativeZero{lhs.NegativeZero ||
+                    signsMayDiffer(lhs.Lo, lhs.Hi, rhs.Lo, rhs.Hi)};
+  return {std::min(corners), std::max(corners), integral, negativeZero,
+          lhs.Precision};
+}
+
+ValueRange ValueRange::Boolean(FPPrecision precision) {
+  return {0, 1, /*integral=*/true, /*negativeZero=*/false, precision};
+}
+
+ValueRange ValueRange::Union(ValueRange lhs, ValueRange rhs) {
+  if (!lhs.Bounded || !rhs.Bounded) {
+    return {};
+  }
+  return {std::min(lhs.Lo, rhs.Lo), std::max(lhs.Hi, rhs.Hi),
+          lhs.Integral && rhs.Integral, lhs.NegativeZero || rhs.NegativeZero,
+          lhs.Precision};
+}
+
+ValueRange ValueRange::Counter(ValueRange start, ValueRange end) {
+  if (!start.Bounded || !end.Bounded) {
+    return {};
+  }
+  // start + k never exceeds end when the loop runs, but for the rounding of
+  // non-integral values. Adding +0.0 turns -0.0 into +0.0
+  double hi{std::max(start.Lo, end.Hi)};
+  return {start.Lo, start.Integral ? hi : hi + 1, start.Integral,
+          /*negativeZero=*/false, start.Precision};
+}
+
+bool ValueRange::fitsInteger() const {
+  double maxExactInteger{Precision == FPPrecision::F32 ? MaxExactFloatInteger
+                                                       : MaxExactDoubleInteger};
+  return Bounded && Integral && !NegativeZero && -maxExactInteger < Lo &&
+         Hi < maxExactInteger;
+}
+
+namespace {
+
+/// Interprets the body of a function in order, tracking the range of every
+/// variable at each point. Variables are never assigned in the branches of a
+/// ConditionalExpr, and those assigned in a loop are unknown from its start,
+/// so a single pass suffices
+struct RangeAnalyzer final {
+  RangeAnalyzer(const sema::Scope &scope, FPPrecision precision,
+                ValueRanges &ranges)
+      : TheScope{scope}, Precision{precision}, TheRanges{ranges} {}
+
+  void analyze(const ast::FunctionDecl &fn) {
+    for (const ast::StmtPtr &stmt : fn.getBody()->getStmts()) {
+      analyze(*stmt);
+    }
+  }
+
+  /// Root Expressions of the body, in order
+  std::vector<const ast::Expr *> Roots;
+  /// Every assignment of the body, as its Var and assigned Expression
+  std::vector<std::pair<const sema::Symbol *, const ast::Expr *>> Assignments;
+
+private:
+  void analyze(const ast::Stmt &stmt) {
+    if (const auto *es{llvm::dyn_cast<ast::ExprStmt>(&stmt)}) {
+      analyze(*es->getExpr());
+    } else if (const auto *rs{llvm::dyn_cast<ast::ReturnStmt>(&stmt)}) {
+      analyze(*rs->getValue());
+    } else {
+      analyze(llvm::cast<ast::ForStmt>(stmt));
+    }
+  }
+
+  void analyze(const ast::ForStmt &fs) {
+    analyze(*fs.getStart());
+    analyze(*fs.getEnd());
+    const sema::Symbol *var{TheScope.lookup(fs.getVar())};
+    std::vector<const sema::Symbol *> assigned{
+        sema::GetAssignedVars(fs, TheScope)};
+    auto outer{Vars.find(var)};
+    std::optional<ValueRange> outerRange;
+    if (outer != Vars.end()) {
+      outerRange = outer->second;
+    }
+
+    for (const sema::Symbol *symbol : assigned) {
+      Vars.erase(symbol);
+    }
+    Vars[var] = ValueRange::Counter(TheRanges.getRange(*fs.getStart()),
+                                    TheRanges.getRange(*fs.getEnd()));
+    // The loop variable is stored as an integer only if both bounds are
+    Assignments.emplace_back(var, fs.getStart());
+    Assignments.emplace_back(var, fs.getEnd());
+    for (const ast::StmtPtr &stmt : fs.getBody()->getStmts()) {
+      analyze(*stmt);
+    }
+
+    for (const sema::Symbol *symbol : assigned) {
+      Vars.erase(symbol);
+    }
+    if (outerRange) {
+      Vars[var] = *outerRange;
+    } else {
+      Vars.erase(var);
+    }
+  }
+
+  void analyze(const ast::Expr &expr) {
+    Roots.push_back(&expr);
+    eval(expr);
+  }
+
+  ValueRange eval(const ast::Expr &expr) {
+    ValueRange range{evalImpl(expr)};
+    TheRanges.Ranges[&expr] = range;
+    return range;
+  }
+
+  ValueRange evalImpl(const ast::Expr &expr) {
+    switch (expr.getKind()) {
+    case ast::Node::Kind::NumberExpr:
+      return ValueRange::Constant(
+          static_cast<const ast::NumberExpr &>(expr).getValue(), Precision);
+    case ast::Node::Kind::IdentifierExpr: {
+      const auto &id{static_cast<const ast::IdentifierExpr &>(expr)};
+      // Parameters, and Vars read before being assigned, are unknown
+      return Vars.lookup(TheScope.lookup(id.getName()));
+    }
+    case ast::Node::Kind::CallExpr: {
+      for (const ast::ExprPtr &arg :
+           static_cast<const ast::CallExpr &>(expr).getArgs()) {
+        eval(*arg);
+      }
+      return {};
+    }
+    case ast::Node::Kind::BinaryExpr: {
+      const auto &bin{static_cast<const ast::BinaryExpr &>(expr)};
+      if (bin.getOp() == ast::BinaryExpr::Op::Assign) {
+        const auto &id{static_cast<const ast::IdentifierExpr &>(*bin.getLHS())};
+        const sema::Symbol *symbol{TheScope.lookup(id.getName())};
+        ValueRange range{eval(*bin.getRHS())};
+        TheRanges.Ranges[bin.getLHS()] = range;
+        Vars[symbol] = range;
+        Assignments.emplace_back(symbol, bin.getRHS());
+        return range;
+      }
+      ValueRange lhs{eval(*bin.getLHS())};
+      ValueRange rhs{eval(*bin.getRHS())};
+      switch (bin.getOp()) {
+      case ast::BinaryExpr::Op::Add:
+        return ValueRange::Add(lhs, rhs);
+      case ast::BinaryExpr::Op::Sub:
+        return ValueRange::Sub(lhs, rhs);
+      case ast::BinaryExpr::Op::Mul:
+        return ValueRange::Mul(lhs, rhs);
+      case ast::BinaryExpr::Op::Div:
+        return ValueRange::Div(lhs, rhs);
+      case ast::BinaryExpr::Op::Less:
+      case ast::BinaryExpr::Op::LessEqual:
+      case ast::BinaryExpr::Op::Greater:
+      case ast::BinaryExpr::Op::GreaterEqual:
+      case ast::BinaryExpr::Op::Equal:
+      case ast::BinaryExpr::Op::NotEqual:
+        return ValueRange::Boolean(Precision);
+      case ast::BinaryExpr::Op::Assign:
+        break;
+      }
+      MUA_COVERS_ALL_CASES;
+    }
+    case ast::Node::Kind::ConditionalExpr: {
+      const auto &cond{static_cast<const ast::ConditionalExpr &>(expr)};
+      eval(*cond.getCond());
+      return ValueRange::Union(eval(*cond.getThen()), eval(*cond.getElse()));
+    }
+    case ast::Node::Kind::ExprStmt:
+    case ast::Node::Kind::ReturnStmt:
+    case ast::Node::Kind::CompoundStmt:
+    case ast::Node::Kind::ForStmt:
+    case ast::Node::Kind::ParamDecl:
+    case ast::Node::Kind::FunctionDecl:
+    case ast::Node::Kind::TranslationUnit:
+      break;
+    }
+    MUA_COVERS_ALL_CASES;
+  }
+
+  const sema::Scope &TheScope;
+  FPPrecision Precision;
+  ValueRanges &TheRanges;
+  llvm::DenseMap<const sema::Symbol *, ValueRange> Vars;
+};
+
+/// Decides which Expressions are lowered with integer arithmetic, given the
+/// Vars currently stored as integers
+struct IntegerSelector final {
+  IntegerSelector(const sema::Scope &scope, ValueRanges &ranges)
+      : TheScope{scope}, TheRanges{ranges} {}
+
+  /// Whether the Expression is lowered as an i64. If recording, every such
+  /// Expression (including nested ones) is added to the IntegerExprs
+  bool select(const ast::Expr &expr, bool record) {
+    bool selected{selectImpl(expr, record)};
+    if (selected && record) {
+      TheRanges.IntegerExprs.insert(&expr);
+    }
+    return selected;
+  }
+
+private:
+  bool selectImpl(const ast::Expr &expr, bool record) {
+    switch (expr.getKind()) {
+    case ast::Node::Kind::NumberExpr:
+      return TheRanges.getRange(expr).fitsInteger();
+    case ast::Node::Kind::IdentifierExpr: {
+      const auto &id{static_cast<const ast::IdentifierExpr &>(expr)};
+      return TheRanges.IntegerVars.contains(TheScope.lookup(id.getName()));
+    }
+    case ast::Node::Kind::CallExpr: {
+      for (const ast::ExprPtr &arg :
+           static_cast<const ast::CallExpr &>(expr).getArgs()) {
+        select(*arg, record);
+      }
+      return false;
+    }
+    case ast::Node::Kind::BinaryExpr: {
+      const auto &bin{static_cast<const ast::BinaryExpr &>(expr)};
+      // Both operands are always visited so that nested Expressions are
+      // recorded
+      bool lhs{select(*bin.getLHS(), record)};
+      bool rhs{select(*bin.getRHS(), record)};
+      if (bin.getOp() == ast::BinaryExpr::Op::Assign) {
+        return lhs;
+      }
+      // Comparisons of integers are lowered as icmps, whose result is
+      // extended to an i64
+      return lhs && rhs && TheRanges.getRange(expr).fitsInteger();
+    }
+    case ast::Node::Kind::ConditionalExpr: {
+      const auto &cond{static_cast<const ast::ConditionalExpr &>(expr)};
+      select(*cond.getCond(), record);
+      bool thenExpr{select(*cond.getThen(), record)};
+      bool elseExpr{select(*cond.getElse(), record)};
+      return thenExpr && elseExpr && TheRanges.getRange(expr).fitsInteger();
+    }
+    case ast::Node::Kind::ExprStmt:
+    case ast::Node::Kind::ReturnStmt:
+    case ast::Node::Kind::CompoundStmt:
+    case ast::Node::Kind::ForStmt:
+    case ast::Node::Kind::ParamDecl:
+    case ast::Node::Kind::FunctionDecl:
+    case ast::Node::Kind::TranslationUnit:
+      break;
+    }
+    MUA_COVERS_ALL_CASES;
+  }
+
+  const sema::Scope &TheScope;
+  ValueRanges &TheRanges;
+};
+
+} // namespace
+
+ValueRanges mua::lower::AnalyzeValueRanges(const ast::FunctionDecl &fn,
+                                           const sema::Scope &scope,
+                                           FPPrecision precision) {
+  ValueRanges ranges;
+  RangeAnalyzer rangeAnalyzer{scope, precision, ranges};
+  rangeAnalyzer.analyze(fn);
+
+  // Start from every assigned Var and drop those with an assignment that is not
+  // lowered as an integer until none is left. Dropping a Var may only turn
+  // other Expressions from integers into floating-point numbers, so this
+  // terminates. Params are always stored as floating-point numbers
+  for (const auto &[symbol, value] : rangeAnalyzer.Assignments) {
+    if (symbol->getKind() == sema::Symbol::Kind::Var) {
+      ranges.IntegerVars.insert(symbol);
+    }
+  }
+  IntegerSelector integerSelector{scope, ranges};
+  for (bool changed{true}; changed;) {
+    changed = false;
+    for (const auto &[symbol, value] : rangeAnalyzer.Assignments) {
+      if (ranges.IntegerVars.contains(symbol) &&
+          !integerSelector.select(*value, /*record=*/false)) {
+        ranges.IntegerVars.erase(symbol);
+        changed = true;
+      }
+    }
+  }
+  for (const ast::Expr *root : rangeAnalyzer.Roots) {
+    integerSelector.select(*root, /*record=*/true);
+  }
+  return ranges;
+}
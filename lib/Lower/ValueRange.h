@@ -0,0 +1,117 @@
+// MIT License
+//
+// Copyright (c) 2026-onwards Iñaki Amatria-Barral
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef MUA_LIB_LOWER_VALUERANGE_H
+#define MUA_LIB_LOWER_VALUERANGE_H
+
+#include "mua/Support/FPPrecision.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+
+namespace mua::ast {
+class Expr;
+struct FunctionDecl;
+} // namespace mua::ast
+
+namespace mua::sema {
+struct Scope;
+struct Symbol;
+} // namespace mua::sema
+
+namespace mua::lower {
+
+/// Abstract value of an expression computed with a given precision. Either
+/// unknown, or a finite interval [Lo, Hi] (so never NaN nor infinite) that may
+/// be known to hold only integers and may be known to never be -0.0
+struct ValueRange final {
+  /// Range about which nothing is known
+  ValueRange() = default;
+
+  /// Range holding exactly the given value, once rounded to the precision
+  static ValueRange Constant(double, FPPrecision);
+
+  static ValueRange Add(ValueRange, ValueRange);
+  static ValueRange Sub(ValueRange, ValueRange);
+  static ValueRange Mul(ValueRange, ValueRange);
+  static ValueRange Div(ValueRange, ValueRange);
+
+  /// Range of the result of a comparison, 0 or 1
+  static ValueRange Boolean(FPPrecision);
+
+  /// Smallest range holding the values of both ranges
+  static ValueRange Union(ValueRange, ValueRange);
+
+  /// Range of the variable of a loop running from start to end
+  static ValueRange Counter(ValueRange start, ValueRange end);
+
+  /// Whether every value is finite and not NaN
+  bool isBounded() const { return Bounded; }
+
+  /// Whether every value is an integer that is exactly representable both in
+  /// the floating-point format and as an i64, and never -0.0. Computing such
+  /// values with integer arithmetic gives the same results as computing them
+  /// as floating-point numbers
+  bool fitsInteger() const;
+
+  double getLo() const { return Lo; }
+  double getHi() const { return Hi; }
+
+private:
+  ValueRange(double lo, double hi, bool integral, bool negativeZero,
+             FPPrecision);
+
+  bool contains(double value) const { return Lo <= value && value <= Hi; }
+
+  double Lo{0};
+  double Hi{0};
+  bool Bounded{false};
+  bool Integral{false};
+  bool NegativeZero{true};
+  FPPrecision Precision{FPPrecision::F64};
+};
+
+/// Result of value-range analysis over the body of a function
+struct ValueRanges final {
+  /// Range of every expression
+  llvm::DenseMap<const ast::Expr *, ValueRange> Ranges;
+  /// Variables whose every assignment fits an integer. They are lowered as i64
+  llvm::DenseSet<const sema::Symbol *> IntegerVars;
+  /// Expressions whose value fits an integer and whose operands are lowered as
+  /// i64. They are lowered with integer arithmetic
+  llvm::DenseSet<const ast::Expr *> IntegerExprs;
+
+  ValueRange getRange(const ast::Expr &expr) const {
+    return Ranges.lookup(&expr);
+  }
+};
+
+/// Compute the range and integrality of every expression and variable of a
+/// function, computed with the given precision, by abstract interpretation of
+/// its body. Parameters are unknown, as they come from (or go to) the function
+/// boundary as floating-point numbers, and so are the variables assigned in
+/// loops. Loop variables are integers if both bounds are
+ValueRanges AnalyzeValueRanges(const ast::FunctionDecl &, const sema::Scope &,
+                               FPPrecision);
+
+} // namespace mua::lower
+
+#endif // MUA_LIB_LOWER_VALUERANGE_H
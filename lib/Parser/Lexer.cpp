@@ -69,6 +69,7 @@ Token Lexer::lex() {
 #define TOKEN(...)
 #define KEYWORD(name, spelling) .Case(spelling, Token::name)
 #define PUNCT(...)
+#define PUNCT2(...)
 #include "Token.def"
         .Default(Token::Identifier);
   }
@@ -86,6 +87,19 @@ Token Lexer::lex() {
     return Token::Number;
   }
 
+  // Two-character punctuation, before its first character is taken alone
+#define TOKEN(...)
+#define KEYWORD(...)
+#define PUNCT(...)
+#define PUNCT2(name, spelling)                                                 \
+  if (peek() == spelling[0] && peek(/*lookahead=*/1) == spelling[1]) {         \
+    advance();                                                                 \
+    advance();                                                                 \
+    Range = makeRange(begin, getOffset());                                     \
+    return Token::name;                                                        \
+  }
+#include "Token.def"
+
   // Single-character punctuation
   Token token{Token::Invalid};
   switch (peek()) {
@@ -95,6 +109,7 @@ Token Lexer::lex() {
   case ch:                                                                     \
     token = Token::name;                                                       \
     break;
+#define PUNCT2(...)
 #include "Token.def"
   }
   advance();
@@ -74,6 +74,18 @@ struct BinaryExprOp final {
       return BinaryExprOp{ast::BinaryExpr::Op::Mul};
     case Token::Slash:
       return BinaryExprOp{ast::BinaryExpr::Op::Div};
+    case Token::Less:
+      return BinaryExprOp{ast::BinaryExpr::Op::Less};
+    case Token::LessEqual:
+      return BinaryExprOp{ast::BinaryExpr::Op::LessEqual};
+    case Token::Greater:
+      return BinaryExprOp{ast::BinaryExpr::Op::Greater};
+    case Token::GreaterEqual:
+      return BinaryExprOp{ast::BinaryExpr::Op::GreaterEqual};
+    case Token::EqualEqual:
+      return BinaryExprOp{ast::BinaryExpr::Op::Equal};
+    case Token::TildeEqual:
+      return BinaryExprOp{ast::BinaryExpr::Op::NotEqual};
     case Token::EndOfFile:
     case Token::Invalid:
     case Token::Identifier:
@@ -81,9 +93,15 @@ struct BinaryExprOp final {
     case Token::Function:
     case Token::Return:
     case Token::End:
+    case Token::If:
+    case Token::Then:
+    case Token::Else:
+    case Token::For:
+    case Token::Do:
     case Token::Comma:
     case Token::LParen:
     case Token::RParen:
+    case Token::At:
       return std::nullopt;
     }
     MUA_COVERS_ALL_CASES;
@@ -95,6 +113,13 @@ struct BinaryExprOp final {
     switch (Op) {
     case ast::BinaryExpr::Op::Assign:
       return 10;
+    case ast::BinaryExpr::Op::Less:
+    case ast::BinaryExpr::Op::LessEqual:
+    case ast::BinaryExpr::Op::Greater:
+    case ast::BinaryExpr::Op::GreaterEqual:
+    case ast::BinaryExpr::Op::Equal:
+    case ast::BinaryExpr::Op::NotEqual:
+      return 15;
     case ast::BinaryExpr::Op::Add:
     case ast::BinaryExpr::Op::Sub:
       return 20;
@@ -113,6 +138,12 @@ struct BinaryExprOp final {
     case ast::BinaryExpr::Op::Sub:
     case ast::BinaryExpr::Op::Mul:
     case ast::BinaryExpr::Op::Div:
+    case ast::BinaryExpr::Op::Less:
+    case ast::BinaryExpr::Op::LessEqual:
+    case ast::BinaryExpr::Op::Greater:
+    case ast::BinaryExpr::Op::GreaterEqual:
+    case ast::BinaryExpr::Op::Equal:
+    case ast::BinaryExpr::Op::NotEqual:
       return false;
     }
     MUA_COVERS_ALL_CASES;
@@ -158,19 +189,32 @@ private:
       return parseNumberExpr(context);
     case Token::Identifier:
       return parseIdentifierOrCallExpr();
+    case Token::If:
+      return parseConditionalExpr();
     case Token::EndOfFile:
     case Token::Invalid:
     case Token::Function:
     case Token::Return:
     case Token::End:
+    case Token::Then:
+    case Token::Else:
+    case Token::For:
+    case Token::Do:
     case Token::Equal:
     case Token::Comma:
     case Token::LParen:
     case Token::RParen:
+    case Token::At:
     case Token::Plus:
     case Token::Minus:
     case Token::Star:
     case Token::Slash:
+    case Token::Less:
+    case Token::Greater:
+    case Token::LessEqual:
+    case Token::GreaterEqual:
+    case Token::EqualEqual:
+    case Token::TildeEqual:
       return error<ast::Expr>(Expected::Kind::Expr, context);
     }
     MUA_COVERS_ALL_CASES;
@@ -219,6 +263,43 @@ private:
         name, std::move(args), source::Range{name.getRange().getBegin(), end});
   }
 
+  ast::ExprPtr parseConditionalExpr() {
+    source::Position begin{TheLexer.getRange().getBegin()};
+    TheLexer.consume(Token::If);
+
+    ast::ExprPtr cond{parseExpr("after if")};
+    if (!cond) {
+      return nullptr;
+    }
+
+    if (TheLexer.getCurrent() != Token::Then) {
+      return error<ast::Expr>(Token::Then, "after if condition");
+    }
+    TheLexer.consume(Token::Then);
+
+    ast::ExprPtr thenExpr{parseExpr("after then")};
+    if (!thenExpr) {
+      return nullptr;
+    }
+
+    if (TheLexer.getCurrent() != Token::Else) {
+      return error<ast::Expr>(Token::Else, "after then branch");
+    }
+    TheLexer.consume(Token::Else);
+
+    // The else branch extends as far to the right as possible, so
+    // `if c then 1 else 2 + x` adds x to the else branch only
+    ast::ExprPtr elseExpr{parseExpr("after else")};
+    if (!elseExpr) {
+      return nullptr;
+    }
+    source::Position end{elseExpr->getRange().getEnd()};
+
+    return std::make_unique<ast::ConditionalExpr>(
+        std::move(cond), std::move(thenExpr), std::move(elseExpr),
+        source::Range{begin, end});
+  }
+
   ast::ExprPtr parseBinaryExpr(int minPrec, llvm::StringRef context) {
     ast::ExprPtr lhs{parsePrimaryExpr(context)};
     if (!lhs) {
@@ -257,20 +338,33 @@ private:
     switch (TheLexer.getCurrent()) {
     case Token::Return:
       return parseReturnStmt();
+    case Token::For:
+      return parseForStmt();
     case Token::EndOfFile:
     case Token::Invalid:
     case Token::Identifier:
     case Token::Number:
     case Token::Function:
     case Token::End:
+    case Token::If:
+    case Token::Then:
+    case Token::Else:
+    case Token::Do:
     case Token::Equal:
     case Token::Comma:
     case Token::LParen:
     case Token::RParen:
+    case Token::At:
     case Token::Plus:
     case Token::Minus:
     case Token::Star:
     case Token::Slash:
+    case Token::Less:
+    case Token::Greater:
+    case Token::LessEqual:
+    case Token::GreaterEqual:
+    case Token::EqualEqual:
+    case Token::TildeEqual:
       return parseExprStmt(context);
     }
     MUA_COVERS_ALL_CASES;
@@ -298,6 +392,52 @@ private:
                                              source::Range{begin, end});
   }
 
+  ast::StmtPtr parseForStmt() {
+    source::Position begin{TheLexer.getRange().getBegin()};
+    TheLexer.consume(Token::For);
+
+    if (TheLexer.getCurrent() != Token::Identifier) {
+      return error<ast::Stmt>(Token::Identifier, "after for");
+    }
+    source::Text var{TheLexer.getRange()};
+    TheLexer.consume(Token::Identifier);
+
+    if (TheLexer.getCurrent() != Token::Equal) {
+      return error<ast::Stmt>(Token::Equal, "after for loop variable");
+    }
+    TheLexer.consume(Token::Equal);
+
+    ast::ExprPtr start{parseExpr("in for loop start")};
+    if (!start) {
+      return nullptr;
+    }
+
+    if (TheLexer.getCurrent() != Token::Comma) {
+      return error<ast::Stmt>(Token::Comma, "after for loop start");
+    }
+    TheLexer.consume(Token::Comma);
+
+    ast::ExprPtr end{parseExpr("in for loop end")};
+    if (!end) {
+      return nullptr;
+    }
+
+    if (TheLexer.getCurrent() != Token::Do) {
+      return error<ast::Stmt>(Token::Do, "after for loop end");
+    }
+    TheLexer.consume(Token::Do);
+
+    ast::CompoundStmtPtr body{parseCompoundStmt("in for loop body")};
+    if (!body) {
+      return nullptr;
+    }
+    source::Position last{body->getRange().getEnd()};
+
+    return std::make_unique<ast::ForStmt>(var, std::move(start), std::move(end),
+                                          std::move(body),
+                                          source::Range{begin, last});
+  }
+
   ast::CompoundStmtPtr parseCompoundStmt(llvm::StringRef context) {
     source::Position begin{TheLexer.getRange().getBegin()};
 
@@ -317,10 +457,22 @@ private:
   }
 
   ast::FunctionDeclPtr parseFunctionDecl(llvm::StringRef context) {
+    source::Position begin{TheLexer.getRange().getBegin()};
+
+    std::vector<source::Text> annotations;
+    while (TheLexer.getCurrent() == Token::At) {
+      TheLexer.consume(Token::At);
+      if (TheLexer.getCurrent() != Token::Identifier) {
+        return error<ast::FunctionDecl>(Token::Identifier, "after @");
+      }
+      annotations.emplace_back(TheLexer.getRange());
+      TheLexer.consume(Token::Identifier);
+      context = "after function annotation";
+    }
+
     if (TheLexer.getCurrent() != Token::Function) {
       return error<ast::FunctionDecl>(Token::Function, context);
     }
-    source::Position begin{TheLexer.getRange().getBegin()};
     TheLexer.consume(Token::Function);
 
     if (TheLexer.getCurrent() != Token::Identifier) {
@@ -365,7 +517,8 @@ private:
     source::Position end{body->getRange().getEnd()};
 
     return std::make_unique<ast::FunctionDecl>(
-        name, std::move(params), std::move(body), source::Range{begin, end});
+        name, std::move(annotations), std::move(params), std::move(body),
+        source::Range{begin, end});
   }
 
   template <typename T>
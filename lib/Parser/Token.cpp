@@ -35,6 +35,7 @@ llvm::raw_ostream &mua::parser::operator<<(llvm::raw_ostream &os, Token token) {
     return os << spelling;
 #define KEYWORD(name, spelling) TOKEN(name, spelling)
 #define PUNCT(name, ch) TOKEN(name, ch)
+#define PUNCT2(name, spelling) TOKEN(name, spelling)
 #include "Token.def"
   }
   MUA_COVERS_ALL_CASES;
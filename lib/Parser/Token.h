@@ -33,6 +33,7 @@ enum class Token {
 #define TOKEN(name, ...) name,
 #define KEYWORD(name, ...) name,
 #define PUNCT(name, ...) name,
+#define PUNCT2(name, ...) name,
 #include "Token.def"
 };
 
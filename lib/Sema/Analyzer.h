@@ -0,0 +1,91 @@
+// MIT License
+//
+// Copyright (c) 2026-onwards Iñaki Amatria-Barral
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef MUA_LIB_SEMA_ANALYZER_H
+#define MUA_LIB_SEMA_ANALYZER_H
+
+#include "mua/Source/Position.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringRef.h"
+
+#include <string>
+#include <vector>
+
+namespace llvm {
+class Twine;
+class raw_ostream;
+} // namespace llvm
+
+namespace mua::ast {
+struct TranslationUnit;
+} // namespace mua::ast
+
+namespace mua::sema {
+
+struct Scope;
+struct Symbol;
+
+/// Diagnostics reported while analyzing a single FunctionDecl. They are
+/// buffered so that functions analyzed in parallel are reported in source order
+struct Diagnostics final {
+  void error(source::Range, llvm::Twine);
+  void warning(source::Range, llvm::Twine);
+  void note(source::Range, llvm::Twine);
+
+  bool hasError() const { return Error; }
+  llvm::StringRef getBuffer() const { return Buffer; }
+
+private:
+  void report(llvm::StringRef, source::Range, const llvm::Twine &);
+
+  std::string Buffer;
+  bool Error{false};
+};
+
+/// Number of parameters of every declared function. Filled by the declaration
+/// pass so that body analysis never has to read another function's Scope
+using Arities = llvm::DenseMap<const Symbol *, unsigned>;
+
+/// Return the Scope declaring every Builtin, which encloses every global Scope
+Scope &GetBuiltinScope();
+
+/// Declare the signature of every function of the TranslationUnit in the
+/// global Scope, in source order, and record the number of parameters of every
+/// Builtin. Returns the Scope of each function, or nullptr for functions whose
+/// declaration failed
+std::vector<Scope *> DeclareFunctions(const ast::TranslationUnit &, Scope &,
+                                      Arities &,
+                                      llvm::MutableArrayRef<Diagnostics>);
+
+/// Analyze, in parallel, the body of every function of the TranslationUnit
+/// whose Scope is not nullptr. The global Scope must not change meanwhile
+void AnalyzeBodies(const ast::TranslationUnit &, llvm::ArrayRef<Scope *>,
+                   const Arities &, llvm::MutableArrayRef<Diagnostics>);
+
+/// Report Diagnostics to the given output stream in source order. Returns true
+/// if any of them is an error
+bool Report(llvm::ArrayRef<Diagnostics>, llvm::raw_ostream &);
+
+} // namespace mua::sema
+
+#endif // MUA_LIB_SEMA_ANALYZER_H
@@ -0,0 +1,73 @@
+// MIT License
+//
+// Copyright (c) 2026-onwards Iñaki Amatria-Barral
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "mua/Sema/Annotation.h"
+
+#include "mua/AST/Decl.h"
+#include "mua/Support/ErrorHandling.h"
+#include "llvm/ADT/STLExtras.h"
+
+using namespace mua;
+using namespace mua::sema;
+
+namespace {
+
+constexpr Annotation Annotations[]{
+    {Annotation::ID::Inline, "inline"}, {Annotation::ID::NoInline, "noinline"},
+    {Annotation::ID::Hot, "hot"},       {Annotation::ID::Cold, "cold"},
+    {Annotation::ID::Export, "export"},
+};
+
+} // namespace
+
+const Annotation *mua::sema::LookupAnnotation(llvm::StringRef name) {
+  const Annotation *it{llvm::find_if(Annotations,
+                                     [&](const Annotation &annotation) {
+                                       return annotation.Name == name;
+                                     })};
+  return it == std::end(Annotations) ? nullptr : it;
+}
+
+std::optional<Annotation::ID>
+mua::sema::GetIncompatibleAnnotation(Annotation::ID id) {
+  switch (id) {
+  case Annotation::ID::Inline:
+    return Annotation::ID::NoInline;
+  case Annotation::ID::NoInline:
+    return Annotation::ID::Inline;
+  case Annotation::ID::Hot:
+    return Annotation::ID::Cold;
+  case Annotation::ID::Cold:
+    return Annotation::ID::Hot;
+  case Annotation::ID::Export:
+    return std::nullopt;
+  }
+  MUA_COVERS_ALL_CASES;
+}
+
+bool mua::sema::HasAnnotation(const ast::FunctionDecl &fn, Annotation::ID id) {
+  return llvm::any_of(fn.getAnnotations(), [&](source::Text name) {
+    const Annotation *annotation{LookupAnnotation(name)};
+    assert(annotation && "FunctionDecl was not analyzed");
+    return annotation->TheID == id;
+  });
+}
@@ -0,0 +1,88 @@
+// MIT License
+//
+// Copyright (c) 2026-onwards Iñaki Amatria-Barral
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "mua/Sema/Builtin.h"
+
+#include "mua/Sema/Symbol.h"
+#include "mua/Source/File.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "Analyzer.h"
+
+using namespace mua;
+using namespace mua::sema;
+
+namespace {
+
+constexpr Builtin Builtins[]{
+    {Builtin::ID::Sqrt, "sqrt", 1}, {Builtin::ID::Exp, "exp", 1},
+    {Builtin::ID::Log, "log", 1},   {Builtin::ID::Pow, "pow", 2},
+    {Builtin::ID::Fma, "fma", 3},   {Builtin::ID::Min, "min", 2},
+    {Builtin::ID::Max, "max", 2},   {Builtin::ID::Abs, "abs", 1},
+};
+
+/// Scope declaring every Builtin. Symbols need a source Text, so each Builtin
+/// is spelled out as a function signature in a File of its own, which
+/// diagnostics then point to
+struct BuiltinScope final {
+  BuiltinScope() {
+    std::vector<std::pair<source::Offset, source::Offset>> names;
+    llvm::raw_string_ostream os{Text};
+    for (const Builtin &builtin : Builtins) {
+      os << "function ";
+      source::Offset begin{static_cast<source::Offset>(Text.size())};
+      os << builtin.Name;
+      names.emplace_back(begin, static_cast<source::Offset>(Text.size()));
+      os << '(';
+      for (unsigned i{0}; i < builtin.Arity; ++i) {
+        os << (i ? ", " : "") << static_cast<char>('x' + i);
+      }
+      os << ")\n";
+    }
+    TheFile = source::File::Create("<builtin>", Text);
+    for (auto [begin, end] : names) {
+      TheScope.declare(Symbol::Kind::Builtin,
+                       source::Range{TheFile->makePosition(begin),
+                                     TheFile->makePosition(end)});
+    }
+  }
+
+  std::string Text;
+  std::unique_ptr<source::File> TheFile;
+  Scope TheScope{/*parent=*/nullptr};
+};
+
+} // namespace
+
+llvm::ArrayRef<Builtin> mua::sema::GetBuiltins() { return Builtins; }
+
+const Builtin *mua::sema::LookupBuiltin(llvm::StringRef name) {
+  const Builtin *it{llvm::find_if(
+      Builtins, [&](const Builtin &builtin) { return builtin.Name == name; })};
+  return it == std::end(Builtins) ? nullptr : it;
+}
+
+Scope &mua::sema::GetBuiltinScope() {
+  // Built once, and only read afterwards, so it is shared by every analysis
+  static BuiltinScope builtins;
+  return builtins.TheScope;
+}
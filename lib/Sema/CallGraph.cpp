@@ -0,0 +1,142 @@
+// MIT License
+//
+// Copyright (c) 2026-onwards Iñaki Amatria-Barral
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "mua/Sema/CallGraph.h"
+
+#include "mua/AST/Walker.h"
+#include "mua/Sema/Symbol.h"
+#include "llvm/ADT/STLExtras.h"
+
+using namespace mua;
+using namespace mua::sema;
+
+namespace {
+
+/// Collects the functions called by a function body, in order of first call.
+/// Builtins call nothing and always return, so they are left out
+struct CalleeVisitor final {
+  CalleeVisitor(const Scope &scope, std::vector<const Symbol *> &callees)
+      : TheScope{scope}, Callees{callees} {}
+
+  template <typename T> bool onEnter(const T &) { return true; }
+  template <typename T> void onExit(const T &) {}
+
+  bool onEnter(const ast::CallExpr &call) {
+    const Symbol *callee{TheScope.lookup(call.getCallee())};
+    if (callee->getKind() != Symbol::Kind::Builtin &&
+        !llvm::is_contained(Callees, callee)) {
+      Callees.push_back(callee);
+    }
+    return true;
+  }
+
+private:
+  const Scope &TheScope;
+  std::vector<const Symbol *> &Callees;
+};
+
+/// Tarjan's strongly connected components algorithm. Components are found
+/// callees first, so every callee outside of a component is already classified
+/// when the component is
+struct ComponentFinder final {
+  ComponentFinder(
+      const llvm::DenseMap<const Symbol *, std::vector<const Symbol *>>
+          &callees,
+      llvm::DenseSet<const Symbol *> &recursive,
+      llvm::DenseSet<const Symbol *> &terminating)
+      : Callees{callees}, Recursive{recursive}, Terminating{terminating} {}
+
+  void visit(const Symbol *function) {
+    if (!Indices.count(function)) {
+      connect(function);
+    }
+  }
+
+private:
+  llvm::ArrayRef<const Symbol *> getCallees(const Symbol *function) const {
+    return Callees.find(function)->second;
+  }
+
+  unsigned connect(const Symbol *function) {
+    unsigned index{static_cast<unsigned>(Indices.size())};
+    unsigned lowLink{index};
+    Indices[function] = index;
+    Stack.push_back(function);
+    OnStack.insert(function);
+    for (const Symbol *callee : getCallees(function)) {
+      if (auto it{Indices.find(callee)}; it == Indices.end()) {
+        lowLink = std::min(lowLink, connect(callee));
+      } else if (OnStack.contains(callee)) {
+        lowLink = std::min(lowLink, it->second);
+      }
+    }
+    if (lowLink == index) {
+      std::size_t first{static_cast<std::size_t>(llvm::find(Stack, function) -
+                                                 Stack.begin())};
+      llvm::ArrayRef<const Symbol *> component{
+          llvm::ArrayRef<const Symbol *>{Stack}.drop_front(first)};
+      classify(component);
+      for (const Symbol *member : component) {
+        OnStack.erase(member);
+      }
+      Stack.resize(first);
+    }
+    return lowLink;
+  }
+
+  void classify(llvm::ArrayRef<const Symbol *> component) {
+    // A component is a cycle if it has several functions, or a single function
+    // calling itself
+    const Symbol *function{component.front()};
+    if (component.size() > 1 ||
+        llvm::is_contained(getCallees(function), function)) {
+      Recursive.insert(component.begin(), component.end());
+      return;
+    }
+    if (llvm::all_of(getCallees(function), [&](const Symbol *callee) {
+          return Terminating.contains(callee);
+        })) {
+      Terminating.insert(function);
+    }
+  }
+
+  const llvm::DenseMap<const Symbol *, std::vector<const Symbol *>> &Callees;
+  llvm::DenseSet<const Symbol *> &Recursive;
+  llvm::DenseSet<const Symbol *> &Terminating;
+  llvm::DenseMap<const Symbol *, unsigned> Indices;
+  std::vector<const Symbol *> Stack;
+  llvm::DenseSet<const Symbol *> OnStack;
+};
+
+} // namespace
+
+CallGraph::CallGraph(const ast::TranslationUnit &tu, const Scope &scope) {
+  for (const ast::FunctionDeclPtr &fn : tu.getFNs()) {
+    const Symbol *function{scope.lookup(fn->getName())};
+    CalleeVisitor calleeVisitor{*function->getScope(), Callees[function]};
+    ast::Walk(*fn->getBody(), calleeVisitor);
+  }
+  ComponentFinder componentFinder{Callees, Recursive, Terminating};
+  for (const ast::FunctionDeclPtr &fn : tu.getFNs()) {
+    componentFinder.visit(scope.lookup(fn->getName()));
+  }
+}
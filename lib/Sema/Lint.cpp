@@ -0,0 +1,301 @@
+// MIT License
+//
+// Copyright (c) 2026-onwards Iñaki Amatria-Barral
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "mua/Sema/Sema.h"
+
+#include "mua/AST/Walker.h"
+#include "mua/Sema/Symbol.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/Twine.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "Analyzer.h"
+
+using namespace mua;
+using namespace mua::sema;
+
+namespace {
+
+/// Expressions nested deeper than this form a long chain of dependent
+/// operations, evaluated one after the other
+constexpr unsigned MaxExpressionDepth{64};
+
+/// Reports performance warnings about the body of a FunctionDecl. Expressions
+/// are visited in evaluation order and value-numbered, so that repeated
+/// computations of the same value are found even when spelled differently
+struct LintVisitor final {
+  LintVisitor(const Scope &functionScope, Diagnostics &diags)
+      : TheScope{functionScope}, Diags{diags} {}
+
+  template <typename T> bool onEnter(const T &) { return true; }
+  template <typename T> void onExit(const T &) {}
+
+  bool onEnter(const ast::Expr &expr) {
+    if (Arms.contains(&expr)) {
+      Bodies.emplace_back();
+    }
+    return true;
+  }
+
+  void onExit(const ast::Expr &expr) {
+    if (Arms.contains(&expr)) {
+      Bodies.pop_back();
+    }
+  }
+
+  bool onEnter(const ast::BinaryExpr &bin) {
+    if (bin.getOp() == ast::BinaryExpr::Op::Assign) {
+      Targets.insert(bin.getLHS());
+    }
+    return true;
+  }
+
+  bool onEnter(const ast::ConditionalExpr &cond) {
+    Arms.insert(cond.getThen());
+    Arms.insert(cond.getElse());
+    return true;
+  }
+
+  bool onEnter(const ast::ForStmt &fs) {
+    Loops[fs.getBody()] = &fs;
+    return true;
+  }
+
+  bool onEnter(const ast::CompoundStmt &cs) {
+    if (const ast::ForStmt *fs{Loops.lookup(&cs)}) {
+      Bodies.emplace_back();
+      startVersions(*fs);
+    }
+    return true;
+  }
+
+  void onExit(const ast::CompoundStmt &cs) {
+    if (const ast::ForStmt *fs{Loops.lookup(&cs)}) {
+      Bodies.pop_back();
+      startVersions(*fs);
+    }
+  }
+
+  void onExit(const ast::NumberExpr &ne) {
+    llvm::SmallString<32> signature;
+    llvm::raw_svector_ostream{signature}
+        << 'n' << llvm::DoubleToBits(ne.getValue());
+    Infos[&ne] = {getValueNumber(signature), /*Depth=*/1, /*Constant=*/true};
+  }
+
+  void onExit(const ast::IdentifierExpr &id) {
+    const Symbol *symbol{TheScope.lookup(id.getName())};
+    if (Targets.contains(&id)) {
+      FirstWrites.try_emplace(symbol, &id);
+      return;
+    }
+    Read.insert(symbol);
+    // Each assignment starts a new version of the variable
+    llvm::SmallString<32> signature;
+    llvm::raw_svector_ostream{signature}
+        << 'v' << id.getName() << ' ' << Versions.lookup(symbol);
+    Infos[&id] = {getValueNumber(signature), /*Depth=*/1, /*Constant=*/false};
+  }
+
+  void onExit(const ast::CallExpr &call) {
+    llvm::SmallString<32> signature;
+    llvm::raw_svector_ostream os{signature};
+    os << 'c' << call.getCallee();
+    Info info{0, /*Depth=*/1, /*Constant=*/false};
+    bool effects{false};
+    for (const ast::ExprPtr &arg : call.getArgs()) {
+      const Info &argInfo{Infos[arg.get()]};
+      os << ' ' << argInfo.Number;
+      info.Depth = std::max(info.Depth, argInfo.Depth + 1);
+      effects |= argInfo.Number == 0;
+    }
+    if (!effects) {
+      info.Number = getValueNumber(signature);
+      // Functions are pure, so calls with the same arguments return the same
+      // value
+      if (const ast::CallExpr *previous{
+              remember(&Remembered::Calls, info.Number, &call)}) {
+        Diags.warning(call.getRange(),
+                      "call to function " + call.getCallee() +
+                          " is repeated with identical arguments [-Wperf]");
+        Diags.note(previous->getRange(), "previous call is here");
+      }
+    }
+    Infos[&call] = info;
+  }
+
+  void onExit(const ast::BinaryExpr &bin) {
+    if (bin.getOp() == ast::BinaryExpr::Op::Assign) {
+      const auto &id{static_cast<const ast::IdentifierExpr &>(*bin.getLHS())};
+      ++Versions[TheScope.lookup(id.getName())];
+      Infos[&bin] = {0, Infos[bin.getRHS()].Depth + 1, /*Constant=*/false};
+      return;
+    }
+    const Info &lhs{Infos[bin.getLHS()]};
+    const Info &rhs{Infos[bin.getRHS()]};
+    Info info{0, std::max(lhs.Depth, rhs.Depth) + 1,
+              lhs.Constant && rhs.Constant};
+    if (lhs.Number != 0 && rhs.Number != 0) {
+      llvm::SmallString<32> signature;
+      llvm::raw_svector_ostream{signature}
+          << 'b' << static_cast<unsigned>(bin.getOp()) << ' ' << lhs.Number
+          << ' ' << rhs.Number;
+      info.Number = getValueNumber(signature);
+    }
+    if (bin.getOp() == ast::BinaryExpr::Op::Div && rhs.Number != 0 &&
+        !rhs.Constant) {
+      if (const ast::BinaryExpr *previous{
+              remember(&Remembered::Divisions, rhs.Number, &bin)}) {
+        Diags.warning(bin.getRHS()->getRange(),
+                      "repeated division by the same value; multiply by its "
+                      "reciprocal instead [-Wperf]");
+        Diags.note(previous->getRHS()->getRange(),
+                   "previous division is here");
+      }
+    }
+    Infos[&bin] = info;
+  }
+
+  void onExit(const ast::ConditionalExpr &cond) {
+    const Info &condInfo{Infos[cond.getCond()]};
+    const Info &thenInfo{Infos[cond.getThen()]};
+    const Info &elseInfo{Infos[cond.getElse()]};
+    Info info{0,
+              std::max({condInfo.Depth, thenInfo.Depth, elseInfo.Depth}) + 1,
+              condInfo.Constant && thenInfo.Constant && elseInfo.Constant};
+    if (condInfo.Number != 0 && thenInfo.Number != 0 && elseInfo.Number != 0) {
+      llvm::SmallString<32> signature;
+      llvm::raw_svector_ostream{signature}
+          << '?' << condInfo.Number << ' ' << thenInfo.Number << ' '
+          << elseInfo.Number;
+      info.Number = getValueNumber(signature);
+    }
+    Infos[&cond] = info;
+  }
+
+  void onExit(const ast::ExprStmt &es) { checkDepth(*es.getExpr()); }
+
+  void onExit(const ast::ReturnStmt &rs) { checkDepth(*rs.getValue()); }
+
+  void onExit(const ast::FunctionDecl &) {
+    for (const Symbol *symbol : TheScope.getSymbols(Symbol::Kind::Var)) {
+      auto it{FirstWrites.find(symbol)};
+      if (it != FirstWrites.end() && !Read.contains(symbol)) {
+        Diags.warning(it->second->getRange(),
+                      "variable " + symbol->getName() +
+                          " is written but never read [-Wperf]");
+      }
+    }
+  }
+
+private:
+  /// Value number of an Expression (0 if it has effects), with its nesting
+  /// depth and whether it only depends on numbers
+  struct Info final {
+    unsigned Number;
+    unsigned Depth;
+    bool Constant;
+  };
+
+  unsigned getValueNumber(llvm::StringRef signature) {
+    auto [it, inserted]{Signatures.try_emplace(signature, 0)};
+    if (inserted) {
+      it->second = Signatures.size();
+    }
+    return it->second;
+  }
+
+  /// First calls and divisions computing each value number in a body: that of
+  /// the function, of a loop or of a branch of a conditional expression
+  struct Remembered final {
+    llvm::DenseMap<unsigned, const ast::CallExpr *> Calls;
+    llvm::DenseMap<unsigned, const ast::BinaryExpr *> Divisions;
+  };
+
+  /// Returns the first Expr computing a value number in the bodies enclosing
+  /// Expr, or remembers Expr as such in the innermost one and returns nullptr.
+  /// Bodies of loops and branches may run zero times, so what they compute is
+  /// forgotten when they are left
+  template <typename T>
+  const T *remember(llvm::DenseMap<unsigned, const T *> Remembered::*table,
+                    unsigned number, const T *expr) {
+    for (const Remembered &body : Bodies) {
+      if (const T *previous{(body.*table).lookup(number)}) {
+        return previous;
+      }
+    }
+    (Bodies.back().*table)[number] = expr;
+    return nullptr;
+  }
+
+  /// Variables assigned by a loop hold different values in every iteration
+  /// and after the loop, so each of them starts a new version
+  void startVersions(const ast::ForStmt &fs) {
+    for (const Symbol *symbol : GetAssignedVars(fs, TheScope)) {
+      ++Versions[symbol];
+    }
+    ++Versions[TheScope.lookup(fs.getVar())];
+  }
+
+  void checkDepth(const ast::Expr &expr) {
+    unsigned depth{Infos[&expr].Depth};
+    if (depth > MaxExpressionDepth) {
+      Diags.warning(expr.getRange(),
+                    "expression is nested " + llvm::Twine{depth} +
+                        " levels deep, which serializes its evaluation "
+                        "[-Wperf]");
+    }
+  }
+
+  const Scope &TheScope;
+  Diagnostics &Diags;
+
+  /// Identifiers assigned to, which are not reads
+  llvm::DenseSet<const ast::Expr *> Targets;
+  llvm::DenseMap<const ast::Expr *, Info> Infos;
+  llvm::StringMap<unsigned> Signatures;
+  llvm::DenseMap<const Symbol *, unsigned> Versions;
+  llvm::DenseMap<const Symbol *, const ast::IdentifierExpr *> FirstWrites;
+  llvm::DenseSet<const Symbol *> Read;
+  /// Bodies enclosing the Node being visited, innermost last, starting with
+  /// that of the function
+  std::vector<Remembered> Bodies{1};
+  /// Branches of the ConditionalExprs entered so far
+  llvm::DenseSet<const ast::Expr *> Arms;
+  /// Bodies of the ForStmts entered so far
+  llvm::DenseMap<const ast::CompoundStmt *, const ast::ForStmt *> Loops;
+};
+
+} // namespace
+
+void mua::sema::Lint(const ast::TranslationUnit &tu, const Scope &scope,
+                     llvm::raw_ostream &os) {
+  std::vector<Diagnostics> diags(tu.getFNs().size());
+  for (auto [fn, diag] : llvm::zip_equal(tu.getFNs(), diags)) {
+    LintVisitor lintVisitor{*scope.lookup(fn->getName())->getScope(), diag};
+    ast::Walk(*fn, lintVisitor);
+  }
+  Report(diags, os);
+}
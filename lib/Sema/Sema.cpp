@@ -23,23 +23,161 @@
 #include "mua/Sema/Sema.h"
 
 #include "mua/AST/Walker.h"
+#include "mua/Sema/Annotation.h"
+#include "mua/Sema/Builtin.h"
 #include "mua/Sema/Symbol.h"
 #include "mua/Source/File.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include "Analyzer.h"
+
 using namespace mua;
 using namespace mua::sema;
 
+void Diagnostics::error(source::Range range, llvm::Twine message) {
+  report("error", range, message);
+  Error = true;
+}
+
+void Diagnostics::warning(source::Range range, llvm::Twine message) {
+  report("warning", range, message);
+}
+
+void Diagnostics::note(source::Range range, llvm::Twine message) {
+  report("note", range, message);
+}
+
+void Diagnostics::report(llvm::StringRef kind, source::Range range,
+                         const llvm::Twine &message) {
+  llvm::raw_string_ostream os{Buffer};
+  os << kind << ": " << message << '\n';
+  range.getFile()->print(range, os);
+  os << '\n';
+}
+
 namespace {
 
+/// Whether the Symbol names a function, defined in the source or not
+bool isFunction(const Symbol &symbol) {
+  return symbol.getKind() == Symbol::Kind::Function ||
+         symbol.getKind() == Symbol::Kind::Builtin;
+}
+
+/// Declares the signature of a FunctionDecl (its Function and Param Symbols)
+/// without looking into its body
+struct DeclarationVisitor final {
+  DeclarationVisitor(Scope &globalScope, Arities &arities, Diagnostics &diags)
+      : TheArities{arities}, Diags{diags}, CurrentScope{&globalScope} {}
+
+  template <typename T> bool onEnter(const T &) { return true; }
+  template <typename T> void onExit(const T &) {}
+
+  bool onEnter(const ast::CompoundStmt &) { return false; }
+
+  bool onEnter(const ast::ParamDecl &pd) {
+    auto [symbol,
+          declared]{CurrentScope->declare(Symbol::Kind::Param, pd.getName())};
+    if (!declared) {
+      Diags.error(pd.getRange(), "redefinition of parameter " + pd.getName());
+      Diags.note(symbol->getName().getRange(), "previous definition is here");
+      return false;
+    }
+    return true;
+  }
+
+  bool onEnter(const ast::FunctionDecl &fn) {
+    auto [symbol, declared]{
+        CurrentScope->declare(Symbol::Kind::Function, fn.getName())};
+    if (!declared) {
+      Diags.error(fn.getRange(), "redefinition of function " + fn.getName());
+      Diags.note(symbol->getName().getRange(), "previous definition is here");
+      return false;
+    }
+    checkAnnotations(fn);
+    CurrentScope = symbol->getScope();
+    return true;
+  }
+
+  void onExit(const ast::FunctionDecl &) {
+    TheArities[CurrentScope->getSymbol()] =
+        CurrentScope->getSymbols(Symbol::Kind::Param).size();
+    FunctionScope = CurrentScope;
+    CurrentScope = CurrentScope->getParent();
+  }
+
+  /// Scope of the declared function, or nullptr if the declaration failed
+  Scope *getFunctionScope() const { return FunctionScope; }
+
+private:
+  /// Check that every annotation of a function is known, and appears at most
+  /// once and never with an incompatible one
+  void checkAnnotations(const ast::FunctionDecl &fn) {
+    llvm::SmallVector<std::pair<Annotation::ID, source::Text>, 4> seen;
+    auto find{[&](Annotation::ID id) {
+      return llvm::find_if(seen, [&](const auto &pair) {
+        return pair.first == id;
+      });
+    }};
+    for (source::Text name : fn.getAnnotations()) {
+      const Annotation *annotation{LookupAnnotation(name)};
+      if (!annotation) {
+        Diags.error(name.getRange(), "unknown annotation @" + name);
+        continue;
+      }
+      if (auto it{find(annotation->TheID)}; it != seen.end()) {
+        Diags.error(name.getRange(), "duplicate annotation @" + name);
+        Diags.note(it->second.getRange(), "previous annotation is here");
+        continue;
+      }
+      if (std::optional<Annotation::ID> incompatible{
+              GetIncompatibleAnnotation(annotation->TheID)}) {
+        if (auto it{find(*incompatible)}; it != seen.end()) {
+          Diags.error(name.getRange(), "annotation @" + name +
+                                           " is incompatible with @" +
+                                           it->second);
+          Diags.note(it->second.getRange(), "previous annotation is here");
+          continue;
+        }
+      }
+      seen.emplace_back(annotation->TheID, name);
+    }
+  }
+
+  Arities &TheArities;
+  Diagnostics &Diags;
+
+  Scope *CurrentScope;
+  Scope *FunctionScope{nullptr};
+};
+
+/// Analyzes the body of a FunctionDecl whose signature has already been
+/// declared. Only the function's own Scope is modified, so the bodies of
+/// different functions can be analyzed concurrently
 struct AnalyzerVisitor final {
-  AnalyzerVisitor(llvm::raw_ostream &os)
-      : OS{os}, GlobalScope{std::make_unique<Scope>(/*parent=*/nullptr)},
-        CurrentScope{GlobalScope.get()} {}
+  AnalyzerVisitor(Scope &functionScope, const Arities &arities,
+                  Diagnostics &diags)
+      : TheArities{arities}, Diags{diags}, CurrentScope{&functionScope} {}
 
   template <typename T> bool onEnter(const T &) { return true; }
   template <typename T> void onExit(const T &) {}
 
+  bool onEnter(const ast::Expr &expr) {
+    if (Arms.contains(&expr)) {
+      ++ArmDepth;
+    }
+    return true;
+  }
+
+  void onExit(const ast::Expr &expr) {
+    if (Arms.contains(&expr)) {
+      --ArmDepth;
+    }
+  }
+
   bool onEnter(const ast::IdentifierExpr &id) {
     CurrentScope->declare(Symbol::Kind::Var, id.getName());
     return true;
@@ -48,19 +186,19 @@ struct AnalyzerVisitor final {
   bool onEnter(const ast::CallExpr &call) {
     const Symbol *symbol{CurrentScope->lookup(call.getCallee())};
     if (!symbol) {
-      error(call.getRange(), "use of undeclared function " + call.getCallee());
+      Diags.error(call.getRange(),
+                  "use of undeclared function " + call.getCallee());
       return false;
     }
-    if (symbol->getKind() != Symbol::Kind::Function) {
-      error(call.getRange(),
-            "called object " + call.getCallee() + " is not a function");
-      note(symbol->getName().getRange(), "previous definition is here");
+    if (!isFunction(*symbol)) {
+      Diags.error(call.getRange(),
+                  "called object " + call.getCallee() + " is not a function");
+      Diags.note(symbol->getName().getRange(), "previous definition is here");
       return false;
     }
-    if (call.getArgs().size() !=
-        symbol->getScope()->getSymbols(Symbol::Kind::Param).size()) {
-      error(call.getRange(), "call to function " + call.getCallee() +
-                                 " with incorrect number of arguments");
+    if (call.getArgs().size() != TheArities.lookup(symbol)) {
+      Diags.error(call.getRange(), "call to function " + call.getCallee() +
+                                       " with incorrect number of arguments");
       return false;
     }
     return llvm::all_of(call.getArgs(), [&](const ast::ExprPtr &arg) {
@@ -72,59 +210,88 @@ struct AnalyzerVisitor final {
     if (bin.getOp() == ast::BinaryExpr::Op::Assign) {
       const auto *id{llvm::dyn_cast<ast::IdentifierExpr>(bin.getLHS())};
       if (!id) {
-        error(bin.getLHS()->getRange(), "expression is not assignable");
+        Diags.error(bin.getLHS()->getRange(), "expression is not assignable");
+        return false;
+      }
+      // Only one branch of a conditional expression is evaluated, so a
+      // variable assigned in a branch would only sometimes hold a value
+      if (ArmDepth > 0) {
+        Diags.error(bin.getRange(), "cannot assign variable " + id->getName() +
+                                        " in a branch of a conditional "
+                                        "expression");
+        return false;
+      }
+      // The trip count is computed before the first iteration, so the loop
+      // variable cannot be used to leave the loop early
+      if (llvm::is_contained(LoopVars, id->getName())) {
+        Diags.error(bin.getRange(), "cannot assign loop variable " +
+                                        id->getName());
         return false;
       }
     }
     return checkValueExpr(*bin.getLHS()) && checkValueExpr(*bin.getRHS());
   }
 
+  bool onEnter(const ast::ConditionalExpr &cond) {
+    Arms.insert(cond.getThen());
+    Arms.insert(cond.getElse());
+    return checkValueExpr(*cond.getCond()) &&
+           checkValueExpr(*cond.getThen()) && checkValueExpr(*cond.getElse());
+  }
+
   bool onEnter(const ast::ExprStmt &es) {
     return checkValueExpr(*es.getExpr());
   }
 
   bool onEnter(const ast::ReturnStmt &rs) {
+    if (!LoopVars.empty()) {
+      Diags.error(rs.getRange(), "cannot return from a for loop");
+      return false;
+    }
     return checkValueExpr(*rs.getValue());
   }
 
-  bool onEnter(const ast::ParamDecl &pd) {
-    auto [symbol,
-          declared]{CurrentScope->declare(Symbol::Kind::Param, pd.getName())};
-    if (!declared) {
-      error(pd.getRange(), "redefinition of parameter " + pd.getName());
-      note(symbol->getName().getRange(), "previous definition is here");
-      return false;
+  bool onEnter(const ast::CompoundStmt &cs) {
+    if (!Loops.empty() && Loops.back()->getBody() == &cs) {
+      LoopVars.push_back(Loops.back()->getVar());
     }
     return true;
   }
 
-  bool onEnter(const ast::FunctionDecl &fn) {
+  void onExit(const ast::CompoundStmt &cs) {
+    if (!Loops.empty() && Loops.back()->getBody() == &cs) {
+      LoopVars.pop_back();
+    }
+  }
+
+  bool onEnter(const ast::ForStmt &fs) {
     auto [symbol, declared]{
-        CurrentScope->declare(Symbol::Kind::Function, fn.getName())};
-    if (!declared) {
-      error(fn.getRange(), "redefinition of function " + fn.getName());
-      note(symbol->getName().getRange(), "previous definition is here");
+        CurrentScope->declare(Symbol::Kind::Var, fs.getVar())};
+    if (!declared && isFunction(*symbol)) {
+      Diags.error(fs.getVar().getRange(),
+                  "invalid use of function " + fs.getVar());
+      Diags.note(symbol->getName().getRange(), "function declared here");
       return false;
     }
-    CurrentScope = symbol->getScope();
+    if (!checkValueExpr(*fs.getStart()) || !checkValueExpr(*fs.getEnd())) {
+      return false;
+    }
+    Loops.push_back(&fs);
     return true;
   }
 
+  void onExit(const ast::ForStmt &) { Loops.pop_back(); }
+
   void onExit(const ast::FunctionDecl &fn) {
     llvm::ArrayRef<ast::StmtPtr> stmts{fn.getBody()->getStmts()};
     if (stmts.empty()) {
-      error(fn.getRange(),
-            "function " + fn.getName() + " must end with a return statement");
+      Diags.error(fn.getRange(), "function " + fn.getName() +
+                                     " must end with a return statement");
     } else if (!llvm::isa<ast::ReturnStmt>(stmts.back().get())) {
-      error(stmts.back()->getRange(), "last statement of function " +
-                                          fn.getName() +
-                                          " must be a return statement");
+      Diags.error(stmts.back()->getRange(), "last statement of function " +
+                                                fn.getName() +
+                                                " must be a return statement");
     }
-    CurrentScope = CurrentScope->getParent();
-  }
-
-  std::unique_ptr<Scope> takeGlobalScope() {
-    return Error ? nullptr : std::move(GlobalScope);
   }
 
 private:
@@ -134,42 +301,149 @@ private:
       return true;
     }
     const Symbol *symbol{CurrentScope->lookup(id->getName())};
-    if (!symbol || symbol->getKind() != Symbol::Kind::Function) {
+    if (!symbol || !isFunction(*symbol)) {
       return true;
     }
-    error(id->getRange(), "invalid use of function " + id->getName());
-    note(symbol->getName().getRange(), "function declared here");
+    Diags.error(id->getRange(), "invalid use of function " + id->getName());
+    Diags.note(symbol->getName().getRange(), "function declared here");
     return false;
   }
 
-  void error(source::Range range, llvm::Twine message) {
-    OS << "error: " << message << '\n';
-    range.getFile()->print(range, OS);
-    OS << '\n';
-    Error = true;
-  }
+  const Arities &TheArities;
+  Diagnostics &Diags;
 
-  void note(source::Range range, llvm::Twine message) {
-    OS << "note: " << message << '\n';
-    range.getFile()->print(range, OS);
-    OS << '\n';
-  }
+  Scope *CurrentScope;
 
-  llvm::raw_ostream &OS;
+  /// Branches of the ConditionalExprs entered so far, and how many of them
+  /// enclose the Expr being visited
+  llvm::SmallPtrSet<const ast::Expr *, 8> Arms;
+  unsigned ArmDepth{0};
 
-  std::unique_ptr<Scope> GlobalScope;
-  Scope *CurrentScope;
+  /// ForStmts entered so far, and the variables of those whose body encloses
+  /// the Node being visited
+  llvm::SmallVector<const ast::ForStmt *, 4> Loops;
+  llvm::SmallVector<llvm::StringRef, 4> LoopVars;
+};
+
+/// Collects the variables assigned by an AST subtree, in source order
+struct AssignmentVisitor final {
+  AssignmentVisitor(const Scope &scope) : TheScope{scope} {}
+
+  template <typename T> bool onEnter(const T &) { return true; }
+  template <typename T> void onExit(const T &) {}
+
+  bool onEnter(const ast::BinaryExpr &bin) {
+    if (bin.getOp() == ast::BinaryExpr::Op::Assign) {
+      const auto *id{llvm::cast<ast::IdentifierExpr>(bin.getLHS())};
+      Assigned.insert(TheScope.lookup(id->getName()));
+    }
+    return true;
+  }
 
-  bool Error{false};
+  bool onEnter(const ast::ForStmt &fs) {
+    Assigned.insert(TheScope.lookup(fs.getVar()));
+    return true;
+  }
+
+  const Scope &TheScope;
+  llvm::SetVector<const Symbol *> Assigned;
 };
 
 } // namespace
 
+std::vector<const Symbol *>
+mua::sema::GetAssignedVars(const ast::ForStmt &fs, const Scope &scope) {
+  AssignmentVisitor assignmentVisitor{scope};
+  ast::Walk(*fs.getBody(), assignmentVisitor);
+  return assignmentVisitor.Assigned.takeVector();
+}
+
+std::vector<Scope *>
+mua::sema::DeclareFunctions(const ast::TranslationUnit &tu, Scope &globalScope,
+                            Arities &arities,
+                            llvm::MutableArrayRef<Diagnostics> diags) {
+  for (const Builtin &builtin : GetBuiltins()) {
+    arities[globalScope.lookup(builtin.Name)] = builtin.Arity;
+  }
+  std::vector<Scope *> scopes;
+  for (auto [fn, diag] : llvm::zip_equal(tu.getFNs(), diags)) {
+    DeclarationVisitor declarationVisitor{globalScope, arities, diag};
+    ast::Walk(*fn, declarationVisitor);
+    scopes.push_back(declarationVisitor.getFunctionScope());
+  }
+  return scopes;
+}
+
+void mua::sema::AnalyzeBodies(const ast::TranslationUnit &tu,
+                              llvm::ArrayRef<Scope *> scopes,
+                              const Arities &arities,
+                              llvm::MutableArrayRef<Diagnostics> diags) {
+  llvm::DefaultThreadPool threadPool;
+  for (auto [fn, scope, diag] : llvm::zip_equal(tu.getFNs(), scopes, diags)) {
+    if (!scope) {
+      continue;
+    }
+    threadPool.async([&fn = *fn, scope = scope, &arities, &diag = diag] {
+      AnalyzerVisitor analyzerVisitor{*scope, arities, diag};
+      ast::Walk(fn, analyzerVisitor);
+    });
+  }
+  threadPool.wait();
+}
+
+bool mua::sema::Report(llvm::ArrayRef<Diagnostics> diags,
+                       llvm::raw_ostream &os) {
+  bool error{false};
+  for (const Diagnostics &diag : diags) {
+    os << diag.getBuffer();
+    error |= diag.hasError();
+  }
+  return error;
+}
+
 std::unique_ptr<Scope> mua::sema::Analyze(const ast::TranslationUnit &tu,
                                           llvm::raw_ostream &os) {
-  AnalyzerVisitor analyzerVisitor{os};
-  ast::Walk(tu, analyzerVisitor);
-  return analyzerVisitor.takeGlobalScope();
+  auto globalScope{std::make_unique<Scope>(&GetBuiltinScope())};
+  std::vector<Diagnostics> diags(tu.getFNs().size());
+  Arities arities;
+
+  // Declare every signature first, in source order, so that function bodies
+  // may refer to functions defined later in the TranslationUnit. The global
+  // Scope is read-only from then on, so bodies are analyzed in parallel
+  std::vector<Scope *> scopes{
+      DeclareFunctions(tu, *globalScope, arities, diags)};
+  AnalyzeBodies(tu, scopes, arities, diags);
+
+  return Report(diags, os) ? nullptr : std::move(globalScope);
+}
+
+bool mua::sema::CheckGradients(const Scope &scope, llvm::raw_ostream &os) {
+  Diagnostics diags;
+  for (const Symbol *symbol : scope.getSymbols(Symbol::Kind::Function)) {
+    llvm::StringRef name{symbol->getName()};
+    if (!name.consume_back(GradientSuffix)) {
+      continue;
+    }
+    if (const Symbol *function{scope.lookup(name)};
+        function && function->getKind() == Symbol::Kind::Function) {
+      diags.error(symbol->getName().getRange(),
+                  "function " + symbol->getName() +
+                      " conflicts with the gradient of function " + name);
+      diags.note(function->getName().getRange(), "function declared here");
+    }
+  }
+  return !Report(diags, os);
+}
+
+bool mua::sema::CheckDispatchTable(const Scope &scope, llvm::raw_ostream &os) {
+  Diagnostics diags;
+  if (const Symbol *function{scope.lookup(DispatchAccessor)};
+      function && function->getKind() == Symbol::Kind::Function) {
+    diags.error(function->getName().getRange(),
+                "function " + function->getName() +
+                    " conflicts with the dispatch table accessor");
+  }
+  return !Report(diags, os);
 }
 
 static void DumpScope(const Scope &scope, llvm::raw_ostream &os,
@@ -0,0 +1,167 @@
+// MIT License
+//
+// Copyright (c) 2026-onwards Iñaki Amatria-Barral
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "mua/Sema/Session.h"
+
+#include "mua/AST/Walker.h"
+#include "mua/Sema/Symbol.h"
+#include "mua/Source/File.h"
+#include "llvm/ADT/StringSet.h"
+
+#include "Analyzer.h"
+
+using namespace mua;
+using namespace mua::sema;
+
+namespace {
+
+/// Collects the names a function body refers to whose meaning depends on the
+/// global Scope, i.e. every name that is not a parameter of the function
+struct DependencyVisitor final {
+  DependencyVisitor(const Scope &functionScope)
+      : FunctionScope{functionScope} {}
+
+  template <typename T> bool onEnter(const T &) { return true; }
+  template <typename T> void onExit(const T &) {}
+
+  bool onEnter(const ast::IdentifierExpr &id) {
+    add(id.getName());
+    return true;
+  }
+
+  bool onEnter(const ast::CallExpr &call) {
+    add(call.getCallee());
+    return true;
+  }
+
+  bool onEnter(const ast::ForStmt &fs) {
+    add(fs.getVar());
+    return true;
+  }
+
+  const llvm::StringSet<> &getNames() const { return Names; }
+
+private:
+  void add(llvm::StringRef name) {
+    const Symbol *symbol{FunctionScope.lookup(name)};
+    if (!symbol || symbol->getKind() != Symbol::Kind::Param) {
+      Names.insert(name);
+    }
+  }
+
+  const Scope &FunctionScope;
+  llvm::StringSet<> Names;
+};
+
+/// Meaning of a global name: the number of parameters of the function it
+/// names, or std::nullopt if it names no function
+std::optional<unsigned> getSignature(const Scope &globalScope,
+                                     const Arities &arities,
+                                     llvm::StringRef name) {
+  const Symbol *symbol{globalScope.lookup(name)};
+  if (!symbol || symbol->getKind() != Symbol::Kind::Function) {
+    return std::nullopt;
+  }
+  return arities.lookup(symbol);
+}
+
+} // namespace
+
+Session::Session() = default;
+Session::~Session() = default;
+
+const Scope *Session::analyze(const ast::TranslationUnit &tu,
+                              llvm::raw_ostream &os) {
+  llvm::ArrayRef<ast::FunctionDeclPtr> fns{tu.getFNs()};
+  auto globalScope{std::make_unique<Scope>(&GetBuiltinScope())};
+  std::vector<Diagnostics> diags(fns.size());
+  Arities arities;
+
+  // Signatures are cheap to declare, and they are what every other function
+  // depends on, so they are always declared again
+  std::vector<Scope *> scopes{
+      DeclareFunctions(tu, *globalScope, arities, diags)};
+
+  // Reuse the Scope of every function whose source text and dependencies did
+  // not change since the previous analysis. Its body needs no analysis
+  const source::File &file{*tu.getRange().getFile()};
+  llvm::StringMap<Entry> entries;
+  for (auto [fn, scope] : llvm::zip_equal(fns, scopes)) {
+    auto it{Entries.find(fn->getName())};
+    if (!scope || it == Entries.end()) {
+      continue;
+    }
+    Entry &entry{it->second};
+    source::Range range{fn->getRange()};
+    if (entry.Text != llvm::StringRef{source::Text{range}} ||
+        !llvm::all_of(entry.Dependencies, [&](const auto &dependency) {
+          return getSignature(*globalScope, arities, dependency.getKey()) ==
+                 dependency.getValue();
+        })) {
+      continue;
+    }
+    Symbol *symbol{scope->getSymbol()};
+    std::unique_ptr<Scope> previous{
+        GlobalScope->lookup(fn->getName())->takeScope()};
+    previous->reattach(globalScope.get(), symbol);
+    previous->relocate(file, std::int64_t{range.getBegin().getOffset()} -
+                                 std::int64_t{entry.Begin});
+    symbol->setScope(std::move(previous));
+    entry.Begin = range.getBegin().getOffset();
+    entries.try_emplace(fn->getName(), std::move(entry));
+    scope = nullptr;
+  }
+
+  Analyzed.clear();
+  for (auto [fn, scope] : llvm::zip_equal(fns, scopes)) {
+    if (scope) {
+      Analyzed.push_back(llvm::StringRef{fn->getName()}.str());
+    }
+  }
+  AnalyzeBodies(tu, scopes, arities, diags);
+
+  if (Report(diags, os)) {
+    GlobalScope.reset();
+    Entries.clear();
+    return nullptr;
+  }
+
+  // Record what every analyzed function depends on for the next analysis
+  for (auto [fn, scope] : llvm::zip_equal(fns, scopes)) {
+    if (!scope) {
+      continue;
+    }
+    DependencyVisitor dependencyVisitor{*scope};
+    ast::Walk(*fn->getBody(), dependencyVisitor);
+    Entry &entry{entries[fn->getName()]};
+    entry.Text = llvm::StringRef{source::Text{fn->getRange()}}.str();
+    entry.Begin = fn->getRange().getBegin().getOffset();
+    for (const auto &name : dependencyVisitor.getNames()) {
+      entry.Dependencies[name.getKey()] =
+          getSignature(*globalScope, arities, name.getKey());
+    }
+  }
+
+  GlobalScope = std::move(globalScope);
+  Entries = std::move(entries);
+  return GlobalScope.get();
+}
@@ -22,11 +22,24 @@
 
 #include "mua/Sema/Symbol.h"
 
+#include "mua/Source/File.h"
 #include "llvm/Support/raw_ostream.h"
 
 using namespace mua;
 using namespace mua::sema;
 
+void Symbol::relocate(const source::File &file, std::int64_t delta) {
+  auto shift{[&](source::Position position) {
+    return file.makePosition(
+        static_cast<source::Offset>(position.getOffset() + delta));
+  }};
+  source::Range range{Name.getRange()};
+  Name = source::Range{shift(range.getBegin()), shift(range.getEnd())};
+  if (TheScope) {
+    TheScope->relocate(file, delta);
+  }
+}
+
 llvm::raw_ostream &mua::sema::operator<<(llvm::raw_ostream &os,
                                          const Symbol &symbol) {
   source::Text name{symbol.getName()};
@@ -41,6 +54,9 @@ llvm::raw_ostream &mua::sema::operator<<(llvm::raw_ostream &os,
   case Symbol::Kind::Var:
     os << "Var";
     break;
+  case Symbol::Kind::Builtin:
+    os << "Builtin";
+    break;
   }
   return os << " : " << name.getRange();
 }
@@ -53,6 +53,12 @@ std::unique_ptr<File> File::Open(llvm::StringRef filename,
   return std::unique_ptr<File>{new File{std::move(*buffer)}};
 }
 
+std::unique_ptr<File> File::Create(llvm::StringRef filename,
+                                   llvm::StringRef text) {
+  return std::unique_ptr<File>{new File{llvm::MemoryBuffer::getMemBuffer(
+      text, filename, /*RequiresNullTerminator=*/false)}};
+}
+
 llvm::MemoryBufferRef File::getBuffer() const { return *Buffer; }
 
 llvm::StringRef File::getFilename() const {
@@ -0,0 +1,127 @@
+// MIT License
+//
+// Copyright (c) 2026-onwards Iñaki Amatria-Barral
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "Arithmetic.h"
+
+#include "mua/Support/ErrorHandling.h"
+#include <cmath>
+
+using namespace mua;
+using namespace mua::transform;
+
+std::optional<llvm::APFloat> mua::transform::Apply(ast::BinaryExpr::Op op,
+                                                   llvm::APFloat lhs,
+                                                   const llvm::APFloat &rhs) {
+  constexpr llvm::RoundingMode rounding{llvm::RoundingMode::NearestTiesToEven};
+  switch (op) {
+  case ast::BinaryExpr::Op::Add:
+    lhs.add(rhs, rounding);
+    break;
+  case ast::BinaryExpr::Op::Sub:
+    lhs.subtract(rhs, rounding);
+    break;
+  case ast::BinaryExpr::Op::Mul:
+    lhs.multiply(rhs, rounding);
+    break;
+  case ast::BinaryExpr::Op::Div:
+    lhs.divide(rhs, rounding);
+    break;
+  case ast::BinaryExpr::Op::Less:
+  case ast::BinaryExpr::Op::LessEqual:
+  case ast::BinaryExpr::Op::Greater:
+  case ast::BinaryExpr::Op::GreaterEqual:
+  case ast::BinaryExpr::Op::Equal:
+  case ast::BinaryExpr::Op::NotEqual:
+    return llvm::APFloat{lhs.getSemantics(), Compare(op, lhs, rhs) ? 1U : 0U};
+  case ast::BinaryExpr::Op::Assign:
+    MUA_COVERS_ALL_CASES;
+  }
+  if (lhs.isNaN()) {
+    return std::nullopt;
+  }
+  return lhs;
+}
+
+bool mua::transform::Compare(ast::BinaryExpr::Op op, const llvm::APFloat &lhs,
+                             const llvm::APFloat &rhs) {
+  llvm::APFloat::cmpResult result{lhs.compare(rhs)};
+  switch (op) {
+  case ast::BinaryExpr::Op::Less:
+    return result == llvm::APFloat::cmpLessThan;
+  case ast::BinaryExpr::Op::LessEqual:
+    return result == llvm::APFloat::cmpLessThan ||
+           result == llvm::APFloat::cmpEqual;
+  case ast::BinaryExpr::Op::Greater:
+    return result == llvm::APFloat::cmpGreaterThan;
+  case ast::BinaryExpr::Op::GreaterEqual:
+    return result == llvm::APFloat::cmpGreaterThan ||
+           result == llvm::APFloat::cmpEqual;
+  case ast::BinaryExpr::Op::Equal:
+    return result == llvm::APFloat::cmpEqual;
+  case ast::BinaryExpr::Op::NotEqual:
+    return result != llvm::APFloat::cmpEqual;
+  case ast::BinaryExpr::Op::Assign:
+  case ast::BinaryExpr::Op::Add:
+  case ast::BinaryExpr::Op::Sub:
+  case ast::BinaryExpr::Op::Mul:
+  case ast::BinaryExpr::Op::Div:
+    MUA_COVERS_ALL_CASES;
+  }
+  MUA_COVERS_ALL_CASES;
+}
+
+std::optional<llvm::APFloat>
+mua::transform::ApplyBuiltin(sema::Builtin::ID id,
+                             llvm::ArrayRef<llvm::APFloat> args) {
+  constexpr llvm::RoundingMode rounding{llvm::RoundingMode::NearestTiesToEven};
+  llvm::APFloat result{args[0]};
+  switch (id) {
+  case sema::Builtin::ID::Sqrt:
+    // Square roots are correctly rounded, so the host computes the same one
+    if (&result.getSemantics() == &llvm::APFloat::IEEEsingle()) {
+      result = llvm::APFloat{std::sqrt(result.convertToFloat())};
+    } else {
+      result = llvm::APFloat{std::sqrt(result.convertToDouble())};
+    }
+    break;
+  case sema::Builtin::ID::Exp:
+  case sema::Builtin::ID::Log:
+  case sema::Builtin::ID::Pow:
+    return std::nullopt;
+  case sema::Builtin::ID::Fma:
+    result.fusedMultiplyAdd(args[1], args[2], rounding);
+    break;
+  case sema::Builtin::ID::Min:
+    result = llvm::minnum(args[0], args[1]);
+    break;
+  case sema::Builtin::ID::Max:
+    result = llvm::maxnum(args[0], args[1]);
+    break;
+  case sema::Builtin::ID::Abs:
+    result.clearSign();
+    break;
+  }
+  if (result.isNaN()) {
+    return std::nullopt;
+  }
+  return result;
+}
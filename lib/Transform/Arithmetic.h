@@ -0,0 +1,54 @@
+// MIT License
+//
+// Copyright (c) 2026-onwards Iñaki Amatria-Barral
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef MUA_LIB_TRANSFORM_ARITHMETIC_H
+#define MUA_LIB_TRANSFORM_ARITHMETIC_H
+
+#include "mua/AST/Expr.h"
+#include "mua/Sema/Builtin.h"
+#include "llvm/ADT/APFloat.h"
+#include <optional>
+
+namespace mua::transform {
+
+/// Apply an arithmetic operator as the lowered code does: IEEE 754 arithmetic
+/// in the format of the operands, rounding to nearest. Returns std::nullopt for
+/// NaN results, whose payload is target-specific and so cannot be computed at
+/// compile time
+std::optional<llvm::APFloat> Apply(ast::BinaryExpr::Op, llvm::APFloat lhs,
+                                   const llvm::APFloat &rhs);
+
+/// Whether a comparison operator holds, as an ordered comparison except for
+/// ~=, which holds whenever == does not
+bool Compare(ast::BinaryExpr::Op, const llvm::APFloat &lhs,
+             const llvm::APFloat &rhs);
+
+/// Apply a Builtin as the lowered code does. Returns std::nullopt for NaN
+/// results, and for Builtins whose result IEEE 754 does not specify exactly
+/// (exp, log and pow), as the math library of the target may round them
+/// differently than the host's
+std::optional<llvm::APFloat> ApplyBuiltin(sema::Builtin::ID,
+                                          llvm::ArrayRef<llvm::APFloat>);
+
+} // namespace mua::transform
+
+#endif // MUA_LIB_TRANSFORM_ARITHMETIC_H
@@ -0,0 +1,298 @@
+// MIT License
+//
+// Copyright (c) 2026-onwards Iñaki Amatria-Barral
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "mua/Transform/ConstEval.h"
+
+#include "Arithmetic.h"
+#include "mua/AST/TreeTransform.h"
+#include "llvm/ADT/APFloat.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Casting.h"
+#include <map>
+#include <optional>
+
+using namespace mua;
+using namespace mua::transform;
+
+namespace {
+
+/// Number of Expressions a single constant call may evaluate
+constexpr unsigned StepBudget{10000};
+
+/// Number of nested calls a single constant call may evaluate
+constexpr unsigned MaxCallDepth{128};
+
+/// Deterministic interpreter of function calls. Values are APFloats so that
+/// results do not depend on the host floating-point environment
+struct Interpreter final {
+  Interpreter(const ast::TranslationUnit &tu, FPPrecision precision)
+      : Precision{precision} {
+    for (const ast::FunctionDeclPtr &fn : tu.getFNs()) {
+      Functions[fn->getName()] = fn.get();
+    }
+  }
+
+  /// Evaluate a call with a fresh step budget. Returns std::nullopt if the
+  /// call cannot be evaluated
+  std::optional<double> evaluate(const ast::CallExpr &call) {
+    std::vector<llvm::APFloat> args;
+    for (const ast::ExprPtr &arg : call.getArgs()) {
+      args.push_back(ToAPFloat(
+          static_cast<const ast::NumberExpr &>(*arg).getValue(), Precision));
+    }
+    Steps = 0;
+    Depth = 0;
+    std::optional<llvm::APFloat> result{this->call(call.getCallee(), args)};
+    if (!result) {
+      return std::nullopt;
+    }
+    return result->convertToDouble();
+  }
+
+private:
+  using Locals = llvm::StringMap<llvm::APFloat>;
+
+  /// Memoization key: a function and the bit patterns of its arguments
+  using CallKey = std::pair<const ast::FunctionDecl *, std::vector<uint64_t>>;
+
+  std::optional<llvm::APFloat> call(llvm::StringRef callee,
+                                    llvm::ArrayRef<llvm::APFloat> args) {
+    if (const sema::Builtin *builtin{sema::LookupBuiltin(callee)}) {
+      return ApplyBuiltin(builtin->TheID, args);
+    }
+    return call(*Functions.lookup(callee), args);
+  }
+
+  std::optional<llvm::APFloat> call(const ast::FunctionDecl &fn,
+                                    llvm::ArrayRef<llvm::APFloat> args) {
+    CallKey key{&fn, {}};
+    for (const llvm::APFloat &arg : args) {
+      key.second.push_back(arg.bitcastToAPInt().getZExtValue());
+    }
+    if (auto it{Results.find(key)}; it != Results.end()) {
+      return it->second;
+    }
+    if (Depth == MaxCallDepth) {
+      return std::nullopt;
+    }
+    ++Depth;
+    Locals locals;
+    for (auto [pd, arg] : llvm::zip_equal(fn.getParams(), args)) {
+      locals.insert_or_assign(pd->getName(), arg);
+    }
+    std::optional<llvm::APFloat> result{execute(*fn.getBody(), locals)};
+    --Depth;
+    // Only successes are memoized: failures depend on the remaining budget
+    if (result) {
+      Results.emplace(std::move(key), *result);
+    }
+    return result;
+  }
+
+  std::optional<llvm::APFloat> execute(const ast::CompoundStmt &body,
+                                       Locals &locals) {
+    for (const ast::StmtPtr &stmt : body.getStmts()) {
+      if (const auto *rs{llvm::dyn_cast<ast::ReturnStmt>(stmt.get())}) {
+        return eval(*rs->getValue(), locals);
+      }
+      if (!run(*stmt, locals)) {
+        return std::nullopt;
+      }
+    }
+    llvm_unreachable("Sema ensures that bodies end with a return");
+  }
+
+  /// Run a Statement other than a return. Returns false if it cannot be
+  /// evaluated
+  bool run(const ast::Stmt &stmt, Locals &locals) {
+    if (const auto *es{llvm::dyn_cast<ast::ExprStmt>(&stmt)}) {
+      return eval(*es->getExpr(), locals).has_value();
+    }
+    const auto &fs{llvm::cast<ast::ForStmt>(stmt)};
+    std::optional<llvm::APFloat> start{eval(*fs.getStart(), locals)};
+    if (!start) {
+      return false;
+    }
+    std::optional<llvm::APFloat> end{eval(*fs.getEnd(), locals)};
+    if (!end) {
+      return false;
+    }
+    // The loop runs floor(end - start) + 1 times if end >= start, where a NaN
+    // difference (of equal infinities) converts to zero
+    std::optional<llvm::APFloat> last;
+    if (llvm::APFloat::cmpResult cmp{end->compare(*start)};
+        cmp == llvm::APFloat::cmpGreaterThan ||
+        cmp == llvm::APFloat::cmpEqual) {
+      last = *end;
+      last->subtract(*start, llvm::APFloat::rmNearestTiesToEven);
+      if (last->isNaN()) {
+        last = llvm::APFloat::getZero(last->getSemantics());
+      }
+      last->roundToIntegral(llvm::APFloat::rmTowardNegative);
+    }
+
+    std::optional<llvm::APFloat> outer;
+    if (auto it{locals.find(fs.getVar())}; it != locals.end()) {
+      outer = it->second;
+    }
+    bool done{true};
+    for (std::uint64_t k{0}; last; ++k) {
+      llvm::APFloat count{start->getSemantics()};
+      count.convertFromAPInt(llvm::APInt{64, k}, /*IsSigned=*/true,
+                             llvm::APFloat::rmNearestTiesToEven);
+      if (count.compare(*last) == llvm::APFloat::cmpGreaterThan) {
+        break;
+      }
+      if (++Steps > StepBudget) {
+        done = false;
+        break;
+      }
+      llvm::APFloat var{*start};
+      var.add(count, llvm::APFloat::rmNearestTiesToEven);
+      locals.insert_or_assign(fs.getVar(), var);
+      if (!llvm::all_of(fs.getBody()->getStmts(),
+                        [&](const ast::StmtPtr &bodyStmt) {
+                          return run(*bodyStmt, locals);
+                        })) {
+        done = false;
+        break;
+      }
+    }
+    if (outer) {
+      locals.insert_or_assign(fs.getVar(), *outer);
+    } else {
+      locals.erase(fs.getVar());
+    }
+    return done;
+  }
+
+  std::optional<llvm::APFloat> eval(const ast::Expr &expr, Locals &locals) {
+    if (++Steps > StepBudget) {
+      return std::nullopt;
+    }
+    switch (expr.getKind()) {
+    case ast::Node::Kind::NumberExpr: {
+      const auto &ne{static_cast<const ast::NumberExpr &>(expr)};
+      return ToAPFloat(ne.getValue(), Precision);
+    }
+    case ast::Node::Kind::IdentifierExpr: {
+      const auto &id{static_cast<const ast::IdentifierExpr &>(expr)};
+      // Reading an uninitialized variable gives an undefined value in the
+      // lowered code, which cannot be reproduced
+      if (auto it{locals.find(id.getName())}; it != locals.end()) {
+        return it->second;
+      }
+      return std::nullopt;
+    }
+    case ast::Node::Kind::CallExpr: {
+      const auto &call{static_cast<const ast::CallExpr &>(expr)};
+      std::vector<llvm::APFloat> args;
+      for (const ast::ExprPtr &arg : call.getArgs()) {
+        std::optional<llvm::APFloat> value{eval(*arg, locals)};
+        if (!value) {
+          return std::nullopt;
+        }
+        args.push_back(*value);
+      }
+      return this->call(call.getCallee(), args);
+    }
+    case ast::Node::Kind::BinaryExpr: {
+      const auto &bin{static_cast<const ast::BinaryExpr &>(expr)};
+      if (bin.getOp() == ast::BinaryExpr::Op::Assign) {
+        const auto &id{static_cast<const ast::IdentifierExpr &>(*bin.getLHS())};
+        std::optional<llvm::APFloat> value{eval(*bin.getRHS(), locals)};
+        if (value) {
+          locals.insert_or_assign(id.getName(), *value);
+        }
+        return value;
+      }
+      // Operands are evaluated in the same order as in the lowered code
+      std::optional<llvm::APFloat> lhs{eval(*bin.getLHS(), locals)};
+      if (!lhs) {
+        return std::nullopt;
+      }
+      std::optional<llvm::APFloat> rhs{eval(*bin.getRHS(), locals)};
+      if (!rhs) {
+        return std::nullopt;
+      }
+      return Apply(bin.getOp(), *lhs, *rhs);
+    }
+    case ast::Node::Kind::ConditionalExpr: {
+      const auto &cond{static_cast<const ast::ConditionalExpr &>(expr)};
+      std::optional<llvm::APFloat> value{eval(*cond.getCond(), locals)};
+      if (!value) {
+        return std::nullopt;
+      }
+      return eval(value->isZero() ? *cond.getElse() : *cond.getThen(), locals);
+    }
+    case ast::Node::Kind::ExprStmt:
+    case ast::Node::Kind::ReturnStmt:
+    case ast::Node::Kind::CompoundStmt:
+    case ast::Node::Kind::ForStmt:
+    case ast::Node::Kind::ParamDecl:
+    case ast::Node::Kind::FunctionDecl:
+    case ast::Node::Kind::TranslationUnit:
+      break;
+    }
+    MUA_COVERS_ALL_CASES;
+  }
+
+  FPPrecision Precision;
+  llvm::StringMap<const ast::FunctionDecl *> Functions;
+  std::map<CallKey, llvm::APFloat> Results;
+  unsigned Steps{0};
+  unsigned Depth{0};
+};
+
+/// Rebuilds the AST, replacing calls with literal arguments by their value.
+/// Arguments are rewritten first, so nested constant calls fold bottom-up
+struct ConstantCallTransform final
+    : public ast::TreeTransform<ConstantCallTransform> {
+  ConstantCallTransform(const ast::TranslationUnit &tu, FPPrecision precision)
+      : TheInterpreter{tu, precision} {}
+
+  ast::ExprPtr transformCallExpr(const ast::CallExpr &call) {
+    ast::ExprPtr result{TreeTransform::transformCallExpr(call)};
+    const auto &rewritten{static_cast<const ast::CallExpr &>(*result)};
+    if (!llvm::all_of(rewritten.getArgs(), [](const ast::ExprPtr &arg) {
+          return llvm::isa<ast::NumberExpr>(arg.get());
+        })) {
+      return result;
+    }
+    if (std::optional<double> value{TheInterpreter.evaluate(rewritten)}) {
+      return std::make_unique<ast::NumberExpr>(*value, call.getRange());
+    }
+    return result;
+  }
+
+private:
+  Interpreter TheInterpreter;
+};
+
+} // namespace
+
+std::unique_ptr<ast::TranslationUnit>
+mua::transform::EvaluateConstantCalls(const ast::TranslationUnit &tu,
+                                      FPPrecision precision) {
+  ConstantCallTransform constantCallTransform{tu, precision};
+  return constantCallTransform.transformTranslationUnit(tu);
+}
@@ -0,0 +1,516 @@
+// MIT License
+//
+// Copyright (c) 2026-onwards Iñaki Amatria-Barral
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "mua/Transform/Rewrite.h"
+
+#include "Arithmetic.h"
+#include "mua/AST/TreeTransform.h"
+#include "mua/Sema/Symbol.h"
+#include "mua/Source/File.h"
+#include "llvm/Support/Casting.h"
+#include "llvm/Support/MathExtras.h"
+#include <string>
+
+using namespace mua;
+using namespace mua::transform;
+
+namespace {
+
+using Op = ast::BinaryExpr::Op;
+
+bool hasAssignments(const ast::Expr &expr) {
+  switch (expr.getKind()) {
+  case ast::Node::Kind::NumberExpr:
+  case ast::Node::Kind::IdentifierExpr:
+    return false;
+  case ast::Node::Kind::CallExpr:
+    return llvm::any_of(static_cast<const ast::CallExpr &>(expr).getArgs(),
+                        [](const ast::ExprPtr &arg) {
+                          return hasAssignments(*arg);
+                        });
+  case ast::Node::Kind::BinaryExpr: {
+    const auto &bin{static_cast<const ast::BinaryExpr &>(expr)};
+    return bin.getOp() == Op::Assign || hasAssignments(*bin.getLHS()) ||
+           hasAssignments(*bin.getRHS());
+  }
+  case ast::Node::Kind::ConditionalExpr: {
+    const auto &cond{static_cast<const ast::ConditionalExpr &>(expr)};
+    return hasAssignments(*cond.getCond()) ||
+           hasAssignments(*cond.getThen()) || hasAssignments(*cond.getElse());
+  }
+  case ast::Node::Kind::ExprStmt:
+  case ast::Node::Kind::ReturnStmt:
+  case ast::Node::Kind::CompoundStmt:
+  case ast::Node::Kind::ForStmt:
+  case ast::Node::Kind::ParamDecl:
+  case ast::Node::Kind::FunctionDecl:
+  case ast::Node::Kind::TranslationUnit:
+    break;
+  }
+  MUA_COVERS_ALL_CASES;
+}
+
+/// Whether two Expressions without assignments compute the same value
+bool isSame(const ast::Expr &lhs, const ast::Expr &rhs) {
+  if (lhs.getKind() != rhs.getKind()) {
+    return false;
+  }
+  switch (lhs.getKind()) {
+  case ast::Node::Kind::NumberExpr:
+    return llvm::APFloat{static_cast<const ast::NumberExpr &>(lhs).getValue()}
+        .bitwiseIsEqual(llvm::APFloat{
+            static_cast<const ast::NumberExpr &>(rhs).getValue()});
+  case ast::Node::Kind::IdentifierExpr:
+    return llvm::StringRef{
+               static_cast<const ast::IdentifierExpr &>(lhs).getName()} ==
+           llvm::StringRef{
+               static_cast<const ast::IdentifierExpr &>(rhs).getName()};
+  case ast::Node::Kind::CallExpr: {
+    const auto &lhsCall{static_cast<const ast::CallExpr &>(lhs)};
+    const auto &rhsCall{static_cast<const ast::CallExpr &>(rhs)};
+    return llvm::StringRef{lhsCall.getCallee()} ==
+               llvm::StringRef{rhsCall.getCallee()} &&
+           llvm::all_of(llvm::zip_equal(lhsCall.getArgs(), rhsCall.getArgs()),
+                        [](auto args) {
+                          return isSame(*std::get<0>(args),
+                                        *std::get<1>(args));
+                        });
+  }
+  case ast::Node::Kind::BinaryExpr: {
+    const auto &lhsBin{static_cast<const ast::BinaryExpr &>(lhs)};
+    const auto &rhsBin{static_cast<const ast::BinaryExpr &>(rhs)};
+    return lhsBin.getOp() == rhsBin.getOp() &&
+           isSame(*lhsBin.getLHS(), *rhsBin.getLHS()) &&
+           isSame(*lhsBin.getRHS(), *rhsBin.getRHS());
+  }
+  case ast::Node::Kind::ConditionalExpr: {
+    const auto &lhsCond{static_cast<const ast::ConditionalExpr &>(lhs)};
+    const auto &rhsCond{static_cast<const ast::ConditionalExpr &>(rhs)};
+    return isSame(*lhsCond.getCond(), *rhsCond.getCond()) &&
+           isSame(*lhsCond.getThen(), *rhsCond.getThen()) &&
+           isSame(*lhsCond.getElse(), *rhsCond.getElse());
+  }
+  case ast::Node::Kind::ExprStmt:
+  case ast::Node::Kind::ReturnStmt:
+  case ast::Node::Kind::CompoundStmt:
+  case ast::Node::Kind::ForStmt:
+  case ast::Node::Kind::ParamDecl:
+  case ast::Node::Kind::FunctionDecl:
+  case ast::Node::Kind::TranslationUnit:
+    break;
+  }
+  MUA_COVERS_ALL_CASES;
+}
+
+/// Collect the operands of a chain of the given operator, in order
+void flatten(const ast::Expr &expr, Op op,
+             std::vector<const ast::Expr *> &operands) {
+  const auto *bin{llvm::dyn_cast<ast::BinaryExpr>(&expr)};
+  if (!bin || bin->getOp() != op) {
+    operands.push_back(&expr);
+    return;
+  }
+  flatten(*bin->getLHS(), op, operands);
+  flatten(*bin->getRHS(), op, operands);
+}
+
+ast::ExprPtr makeBinary(Op op, ast::ExprPtr lhs, ast::ExprPtr rhs,
+                        source::Range range) {
+  return std::make_unique<ast::BinaryExpr>(op, std::move(lhs), std::move(rhs),
+                                           range);
+}
+
+/// Context of the BinaryExpr a Rule is applied to
+struct RuleContext final {
+  /// Operator of the enclosing BinaryExpr, if any
+  std::optional<Op> ParentOp;
+  /// Precision that constants are computed with
+  FPPrecision Precision;
+  /// Scope of the function being rewritten
+  sema::Scope &FunctionScope;
+};
+
+/// A rewrite rule
+struct Rule final {
+  /// Operator of the BinaryExprs the rule applies to
+  Op TheOp;
+  /// Whether the rewritten Expression gives bit-identical results for every
+  /// input. Other rules only apply under RewritePolicy::Fast
+  bool Exact;
+  /// Rewrite the BinaryExpr, or return nullptr if it does not match
+  ast::ExprPtr (*Apply)(const ast::BinaryExpr &, const RuleContext &);
+};
+
+/// x / c -> x * (1 / c), for c a power of two with a normal reciprocal. Both
+/// compute the same real number, rounded once
+ast::ExprPtr rewriteExactReciprocal(const ast::BinaryExpr &bin,
+                                    const RuleContext &context) {
+  const auto *divisor{llvm::dyn_cast<ast::NumberExpr>(bin.getRHS())};
+  llvm::APFloat reciprocal{0.0};
+  if (!divisor || !ToAPFloat(divisor->getValue(), context.Precision)
+                       .getExactInverse(&reciprocal)) {
+    return nullptr;
+  }
+  return makeBinary(Op::Mul, ast::Clone(*bin.getLHS()),
+                    std::make_unique<ast::NumberExpr>(
+                        reciprocal.convertToDouble(), divisor->getRange()),
+                    bin.getRange());
+}
+
+/// x / c -> x * (1 / c), with 1 / c rounded
+ast::ExprPtr rewriteReciprocal(const ast::BinaryExpr &bin,
+                               const RuleContext &context) {
+  const auto *divisor{llvm::dyn_cast<ast::NumberExpr>(bin.getRHS())};
+  if (!divisor || divisor->getValue() == 0) {
+    return nullptr;
+  }
+  std::optional<llvm::APFloat> reciprocal{
+      Apply(Op::Div, ToAPFloat(1.0, context.Precision),
+            ToAPFloat(divisor->getValue(), context.Precision))};
+  if (!reciprocal) {
+    return nullptr;
+  }
+  return makeBinary(Op::Mul, ast::Clone(*bin.getLHS()),
+                    std::make_unique<ast::NumberExpr>(
+                        reciprocal->convertToDouble(), divisor->getRange()),
+                    bin.getRange());
+}
+
+/// a / d + b / d -> (a + b) / d, and likewise for differences
+ast::ExprPtr rewriteCommonDenominator(const ast::BinaryExpr &bin,
+                                      const RuleContext &) {
+  const auto *lhs{llvm::dyn_cast<ast::BinaryExpr>(bin.getLHS())};
+  const auto *rhs{llvm::dyn_cast<ast::BinaryExpr>(bin.getRHS())};
+  if (!lhs || !rhs || lhs->getOp() != Op::Div || rhs->getOp() != Op::Div ||
+      hasAssignments(bin) || !isSame(*lhs->getRHS(), *rhs->getRHS())) {
+    return nullptr;
+  }
+  return makeBinary(Op::Div,
+                    makeBinary(bin.getOp(), ast::Clone(*lhs->getLHS()),
+                               ast::Clone(*rhs->getLHS()), bin.getRange()),
+                    ast::Clone(*lhs->getRHS()), bin.getRange());
+}
+
+/// Polynomial in a single variable with constant coefficients
+struct Polynomial final {
+  /// Precision that coefficients are computed with
+  FPPrecision Precision;
+  std::optional<source::Text> Var;
+  /// Coefficients, indexed by degree
+  std::vector<llvm::APFloat> Coefficients;
+
+  /// Add the terms of a sum, or return false if it is not a polynomial
+  bool addTerms(const ast::Expr &expr, bool negate) {
+    if (const auto *bin{llvm::dyn_cast<ast::BinaryExpr>(&expr)}) {
+      if (bin->getOp() == Op::Add || bin->getOp() == Op::Sub) {
+        return addTerms(*bin->getLHS(), negate) &&
+               addTerms(*bin->getRHS(), bin->getOp() == Op::Sub ? !negate
+                                                                 : negate);
+      }
+    }
+    std::vector<const ast::Expr *> factors;
+    flatten(expr, Op::Mul, factors);
+    std::optional<llvm::APFloat> coefficient{
+        ToAPFloat(negate ? -1.0 : 1.0, Precision)};
+    std::size_t degree{0};
+    for (const ast::Expr *factor : factors) {
+      if (const auto *ne{llvm::dyn_cast<ast::NumberExpr>(factor)}) {
+        coefficient =
+            Apply(Op::Mul, *coefficient, ToAPFloat(ne->getValue(), Precision));
+        if (!coefficient) {
+          return false;
+        }
+      } else if (const auto *id{llvm::dyn_cast<ast::IdentifierExpr>(factor)}) {
+        if (!Var) {
+          Var = id->getName();
+        } else if (llvm::StringRef{*Var} != llvm::StringRef{id->getName()}) {
+          return false;
+        }
+        ++degree;
+      } else {
+        return false;
+      }
+    }
+    if (Coefficients.size() <= degree) {
+      Coefficients.resize(degree + 1, ToAPFloat(0.0, Precision));
+    }
+    std::optional<llvm::APFloat> sum{
+        Apply(Op::Add, Coefficients[degree], *coefficient)};
+    if (!sum) {
+      return false;
+    }
+    Coefficients[degree] = *sum;
+    return true;
+  }
+};
+
+/// Names of the variables holding x^2, x^4, x^8 and so on, in a File of their
+/// own. Names contain a dot, so they never clash with variables of the program
+struct PowerNames final {
+  PowerNames() {
+    for (unsigned n = 1; n < 64; ++n) {
+      Offsets.push_back(Text.size());
+      Text += "pow." + std::to_string(std::uint64_t{1} << n);
+    }
+    Offsets.push_back(Text.size());
+    TheFile = source::File::Create("<rewrite>", Text);
+  }
+
+  /// Name of the variable holding x^(2^n), for n > 0
+  source::Text get(unsigned n) const {
+    return source::Range{TheFile->makePosition(Offsets[n - 1]),
+                         TheFile->makePosition(Offsets[n])};
+  }
+
+private:
+  std::string Text;
+  std::vector<source::Offset> Offsets;
+  std::unique_ptr<source::File> TheFile;
+};
+
+const PowerNames &getPowerNames() {
+  static const PowerNames powerNames;
+  return powerNames;
+}
+
+/// Builds the evaluation of a Polynomial
+struct PolynomialBuilder final {
+  PolynomialBuilder(source::Text var, source::Range range, sema::Scope &scope)
+      : Var{var}, Range{range}, TheScope{scope} {}
+
+  /// c0 + x * (c1 + x * (c2 + ...)), as ((... * x + c2) * x + c1) * x + c0
+  ast::ExprPtr horner(llvm::ArrayRef<llvm::APFloat> coefficients) {
+    while (coefficients.size() > 1 && coefficients.back().isZero()) {
+      coefficients = coefficients.drop_back();
+    }
+    ast::ExprPtr result{makeNumber(coefficients.back())};
+    for (const llvm::APFloat &coefficient :
+         llvm::reverse(coefficients.drop_back())) {
+      result = makeSum(makeProduct(std::move(result), makeVar()), coefficient);
+    }
+    return result;
+  }
+
+  /// low(x) + high(x) * x^k, with k the largest power of two below the number
+  /// of coefficients. Both halves are independent, exposing parallelism
+  ast::ExprPtr estrin(llvm::ArrayRef<llvm::APFloat> coefficients) {
+    if (coefficients.size() <= 2) {
+      return horner(coefficients);
+    }
+    std::size_t k{1};
+    while (k * 2 < coefficients.size()) {
+      k *= 2;
+    }
+    ast::ExprPtr low{estrin(coefficients.take_front(k))};
+    ast::ExprPtr high{estrin(coefficients.drop_front(k))};
+    if (isZero(*high)) {
+      return low;
+    }
+    ast::ExprPtr result{makeProduct(std::move(high), makePower(k))};
+    if (isZero(*low)) {
+      return result;
+    }
+    return makeBinary(Op::Add, std::move(low), std::move(result), Range);
+  }
+
+private:
+  static bool isZero(const ast::Expr &expr) {
+    const auto *ne{llvm::dyn_cast<ast::NumberExpr>(&expr)};
+    return ne && ne->getValue() == 0;
+  }
+
+  ast::ExprPtr makeVar() { return std::make_unique<ast::IdentifierExpr>(Var); }
+
+  ast::ExprPtr makeNumber(const llvm::APFloat &value) {
+    return std::make_unique<ast::NumberExpr>(value.convertToDouble(), Range);
+  }
+
+  /// x^k for k a power of two, by repeated squaring. Each power is computed
+  /// once, where it is first evaluated, into a variable read by later uses
+  ast::ExprPtr makePower(std::size_t k) {
+    if (k == 1) {
+      return makeVar();
+    }
+    unsigned n{llvm::Log2_64(k)};
+    if (Powers.size() <= n) {
+      Powers.resize(n + 1, std::nullopt);
+    }
+    if (Powers[n]) {
+      return std::make_unique<ast::IdentifierExpr>(*Powers[n]);
+    }
+    source::Text name{getPowerNames().get(n)};
+    TheScope.declare(sema::Symbol::Kind::Var, name);
+    ast::ExprPtr square{
+        makeBinary(Op::Mul, makePower(k / 2), makePower(k / 2), Range)};
+    Powers[n] = name;
+    return makeBinary(Op::Assign, std::make_unique<ast::IdentifierExpr>(name),
+                      std::move(square), Range);
+  }
+
+  /// lhs * rhs, omitting a unit constant lhs
+  ast::ExprPtr makeProduct(ast::ExprPtr lhs, ast::ExprPtr rhs) {
+    const auto *ne{llvm::dyn_cast<ast::NumberExpr>(lhs.get())};
+    if (ne && ne->getValue() == 1) {
+      return rhs;
+    }
+    return makeBinary(Op::Mul, std::move(lhs), std::move(rhs), Range);
+  }
+
+  /// expr + c, omitting a zero c
+  ast::ExprPtr makeSum(ast::ExprPtr expr, const llvm::APFloat &c) {
+    if (c.isZero()) {
+      return expr;
+    }
+    return makeBinary(Op::Add, std::move(expr), makeNumber(c), Range);
+  }
+
+  source::Text Var;
+  source::Range Range;
+  sema::Scope &TheScope;
+  /// Variables holding the powers of Var computed so far, indexed by the
+  /// base-2 logarithm of their exponent
+  std::vector<std::optional<source::Text>> Powers;
+};
+
+/// Sums of terms c * x * ... * x -> Horner (or Estrin) form. Only whole sums
+/// are rewritten
+ast::ExprPtr rewritePolynomial(const ast::BinaryExpr &bin,
+                               const RuleContext &context) {
+  if (context.ParentOp == Op::Add || context.ParentOp == Op::Sub) {
+    return nullptr;
+  }
+  Polynomial polynomial{context.Precision, std::nullopt, {}};
+  if (!polynomial.addTerms(bin, /*negate=*/false) || !polynomial.Var) {
+    return nullptr;
+  }
+  llvm::ArrayRef<llvm::APFloat> coefficients{polynomial.Coefficients};
+  while (!coefficients.empty() && coefficients.back().isZero()) {
+    coefficients = coefficients.drop_back();
+  }
+  // Below degree 2 there is nothing to factor
+  if (coefficients.size() < 3) {
+    return nullptr;
+  }
+  PolynomialBuilder builder{*polynomial.Var, bin.getRange(),
+                            context.FunctionScope};
+  return coefficients.size() > 4 ? builder.estrin(coefficients)
+                                 : builder.horner(coefficients);
+}
+
+ast::ExprPtr balance(llvm::ArrayRef<const ast::Expr *> operands, Op op,
+                     source::Range range) {
+  if (operands.size() == 1) {
+    return ast::Clone(*operands.front());
+  }
+  std::size_t half{(operands.size() + 1) / 2};
+  return makeBinary(op, balance(operands.take_front(half), op, range),
+                    balance(operands.drop_front(half), op, range), range);
+}
+
+/// a + (b + (c + d)) -> (a + b) + (c + d), and likewise for products. Operands
+/// keep their order. Only whole chains are rewritten
+ast::ExprPtr rewriteBalanced(const ast::BinaryExpr &bin,
+                             const RuleContext &context) {
+  if (context.ParentOp == bin.getOp() || hasAssignments(bin)) {
+    return nullptr;
+  }
+  std::vector<const ast::Expr *> operands;
+  flatten(bin, bin.getOp(), operands);
+  if (operands.size() < 3) {
+    return nullptr;
+  }
+  return balance(operands, bin.getOp(), bin.getRange());
+}
+
+/// The rewrite rules, tried in order on every BinaryExpr once its operands are
+/// rewritten. Rules on sums see them whole before they are balanced
+const Rule Rules[]{
+    {Op::Div, /*Exact=*/true, rewriteExactReciprocal},
+    {Op::Div, /*Exact=*/false, rewriteReciprocal},
+    {Op::Add, /*Exact=*/false, rewriteCommonDenominator},
+    {Op::Sub, /*Exact=*/false, rewriteCommonDenominator},
+    {Op::Add, /*Exact=*/false, rewritePolynomial},
+    {Op::Sub, /*Exact=*/false, rewritePolynomial},
+    {Op::Add, /*Exact=*/false, rewriteBalanced},
+    {Op::Mul, /*Exact=*/false, rewriteBalanced},
+};
+
+/// Applies the Rules bottom-up
+struct Rewriter final : public ast::TreeTransform<Rewriter> {
+  Rewriter(sema::Scope &scope, RewritePolicy policy, FPPrecision precision)
+      : GlobalScope{scope}, Policy{policy}, Precision{precision} {}
+
+  ast::FunctionDeclPtr transformFunctionDecl(const ast::FunctionDecl &fn) {
+    CurrentScope = GlobalScope.lookup(fn.getName())->getScope();
+    return TreeTransform::transformFunctionDecl(fn);
+  }
+
+  ast::ExprPtr transformCallExpr(const ast::CallExpr &call) {
+    std::optional<Op> parentOp{ParentOp};
+    ParentOp.reset();
+    ast::ExprPtr result{TreeTransform::transformCallExpr(call)};
+    ParentOp = parentOp;
+    return result;
+  }
+
+  ast::ExprPtr transformConditionalExpr(const ast::ConditionalExpr &cond) {
+    std::optional<Op> parentOp{ParentOp};
+    ParentOp.reset();
+    ast::ExprPtr result{TreeTransform::transformConditionalExpr(cond)};
+    ParentOp = parentOp;
+    return result;
+  }
+
+  ast::ExprPtr transformBinaryExpr(const ast::BinaryExpr &bin) {
+    RuleContext context{ParentOp, Precision, *CurrentScope};
+    ParentOp = bin.getOp();
+    ast::ExprPtr result{TreeTransform::transformBinaryExpr(bin)};
+    ParentOp = context.ParentOp;
+    for (const Rule &rule : Rules) {
+      const auto *current{llvm::dyn_cast<ast::BinaryExpr>(result.get())};
+      if (!current || current->getOp() != rule.TheOp ||
+          (!rule.Exact && Policy == RewritePolicy::Strict)) {
+        continue;
+      }
+      if (ast::ExprPtr rewritten{rule.Apply(*current, context)}) {
+        result = std::move(rewritten);
+      }
+    }
+    return result;
+  }
+
+private:
+  sema::Scope &GlobalScope;
+  sema::Scope *CurrentScope{nullptr};
+  RewritePolicy Policy;
+  FPPrecision Precision;
+  std::optional<Op> ParentOp;
+};
+
+} // namespace
+
+std::unique_ptr<ast::TranslationUnit>
+mua::transform::Rewrite(const ast::TranslationUnit &tu, sema::Scope &scope,
+                        RewritePolicy policy, FPPrecision precision) {
+  Rewriter rewriter{scope, policy, precision};
+  return rewriter.transformTranslationUnit(tu);
+}
@@ -0,0 +1,540 @@
+// MIT License
+//
+// Copyright (c) 2026-onwards Iñaki Amatria-Barral
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "mua/Transform/Simplify.h"
+
+#include "Arithmetic.h"
+#include "mua/AST/TreeTransform.h"
+#include "mua/Sema/Builtin.h"
+#include "mua/Sema/Sema.h"
+#include "mua/Sema/Symbol.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/Casting.h"
+#include "llvm/Support/raw_ostream.h"
+#include <cmath>
+
+using namespace mua;
+using namespace mua::transform;
+
+namespace {
+
+/// Whether evaluating the Expression may do more than compute a value: assign
+/// a variable, or call a function (which may not return). Builtins always
+/// return
+bool hasEffects(const ast::Expr &expr) {
+  switch (expr.getKind()) {
+  case ast::Node::Kind::NumberExpr:
+  case ast::Node::Kind::IdentifierExpr:
+    return false;
+  case ast::Node::Kind::CallExpr: {
+    const auto &call{static_cast<const ast::CallExpr &>(expr)};
+    return !sema::LookupBuiltin(call.getCallee()) ||
+           llvm::any_of(call.getArgs(), [](const ast::ExprPtr &arg) {
+             return hasEffects(*arg);
+           });
+  }
+  case ast::Node::Kind::BinaryExpr: {
+    const auto &bin{static_cast<const ast::BinaryExpr &>(expr)};
+    return bin.getOp() == ast::BinaryExpr::Op::Assign ||
+           hasEffects(*bin.getLHS()) || hasEffects(*bin.getRHS());
+  }
+  case ast::Node::Kind::ConditionalExpr: {
+    const auto &cond{static_cast<const ast::ConditionalExpr &>(expr)};
+    return hasEffects(*cond.getCond()) || hasEffects(*cond.getThen()) ||
+           hasEffects(*cond.getElse());
+  }
+  case ast::Node::Kind::ExprStmt:
+  case ast::Node::Kind::ReturnStmt:
+  case ast::Node::Kind::CompoundStmt:
+  case ast::Node::Kind::ForStmt:
+  case ast::Node::Kind::ParamDecl:
+  case ast::Node::Kind::FunctionDecl:
+  case ast::Node::Kind::TranslationUnit:
+    break;
+  }
+  MUA_COVERS_ALL_CASES;
+}
+
+/// Whether `x op value` (or `value op x` if the constant is on the left) is
+/// exactly x for every x, including -0.0
+bool isIdentity(ast::BinaryExpr::Op op, double value, bool onRight) {
+  switch (op) {
+  case ast::BinaryExpr::Op::Add:
+    return value == 0 && std::signbit(value);
+  case ast::BinaryExpr::Op::Sub:
+    return onRight && value == 0 && !std::signbit(value);
+  case ast::BinaryExpr::Op::Mul:
+    return value == 1;
+  case ast::BinaryExpr::Op::Div:
+    return onRight && value == 1;
+  case ast::BinaryExpr::Op::Less:
+  case ast::BinaryExpr::Op::LessEqual:
+  case ast::BinaryExpr::Op::Greater:
+  case ast::BinaryExpr::Op::GreaterEqual:
+  case ast::BinaryExpr::Op::Equal:
+  case ast::BinaryExpr::Op::NotEqual:
+    return false;
+  case ast::BinaryExpr::Op::Assign:
+    break;
+  }
+  MUA_COVERS_ALL_CASES;
+}
+
+/// Rewrites function bodies in a single forward pass with value numbering.
+/// Every rewritten Expression gets a ValueNumber such that Expressions with the
+/// same number compute the same value, which is known for constants. Each
+/// ValueNumber may be held by a variable, which later Expressions computing
+/// it read instead. A final backward pass over each body removes the
+/// assignments that are never read
+struct Simplifier final : public ast::TreeTransform<Simplifier> {
+  Simplifier(const sema::Scope &scope, FPPrecision precision)
+      : GlobalScope{scope}, Precision{precision} {}
+
+  ast::FunctionDeclPtr transformFunctionDecl(const ast::FunctionDecl &fn) {
+    CurrentScope = GlobalScope.lookup(fn.getName())->getScope();
+    Numbers.clear();
+    Constants.clear();
+    Holders.clear();
+    Signatures.clear();
+    ConstantNumbers.clear();
+    Values.clear();
+    WithEffects.clear();
+    for (const ast::ParamDeclPtr &pd : fn.getParams()) {
+      const sema::Symbol *param{CurrentScope->lookup(pd->getName())};
+      ValueNumber vn{makeValueNumber(std::nullopt)};
+      Values[param] = vn;
+      Holders[vn] = param;
+    }
+    return TreeTransform::transformFunctionDecl(fn);
+  }
+
+  ast::CompoundStmtPtr transformCompoundStmt(const ast::CompoundStmt &cs) {
+    std::vector<ast::StmtPtr> stmts;
+    for (const ast::StmtPtr &stmt : cs.getStmts()) {
+      stmts.push_back(transformStmt(*stmt));
+    }
+    return std::make_unique<ast::CompoundStmt>(
+        eliminateDeadAssignments(std::move(stmts)), cs.getRange());
+  }
+
+  ast::ExprPtr transformNumberExpr(const ast::NumberExpr &ne) {
+    return makeNumber(ne.getValue(), ne.getRange());
+  }
+
+  ast::ExprPtr transformIdentifierExpr(const ast::IdentifierExpr &id) {
+    const sema::Symbol *symbol{CurrentScope->lookup(id.getName())};
+    auto it{Values.find(symbol)};
+    if (it == Values.end()) {
+      // Read before any assignment: the value is undefined
+      return record(std::make_unique<ast::IdentifierExpr>(id.getName()),
+                    makeValueNumber(std::nullopt));
+    }
+    ValueNumber vn{it->second};
+    if (std::optional<double> constant{Constants[vn]}) {
+      return makeNumber(*constant, id.getRange());
+    }
+    return makeRead(vn, symbol);
+  }
+
+  ast::ExprPtr transformCallExpr(const ast::CallExpr &call) {
+    llvm::SmallString<32> signature;
+    llvm::raw_svector_ostream os{signature};
+    os << call.getCallee();
+    std::vector<ast::ExprPtr> args;
+    bool effects{false};
+    for (const ast::ExprPtr &arg : call.getArgs()) {
+      args.push_back(transformExpr(*arg));
+      os << ' ' << Numbers.lookup(args.back().get());
+      effects |= WithEffects.contains(args.back().get());
+    }
+    // Functions are pure, so calls with the same arguments may be reused
+    ValueNumber vn{getValueNumber(signature)};
+    if (!effects && isHeld(vn)) {
+      return makeRead(vn, Holders[vn]);
+    }
+    ast::ExprPtr result{std::make_unique<ast::CallExpr>(
+        call.getCallee(), std::move(args), call.getRange())};
+    if (effects || !sema::LookupBuiltin(call.getCallee())) {
+      WithEffects.insert(result.get());
+    }
+    return record(std::move(result), vn);
+  }
+
+  ast::ExprPtr transformBinaryExpr(const ast::BinaryExpr &bin) {
+    if (bin.getOp() == ast::BinaryExpr::Op::Assign) {
+      const auto &id{static_cast<const ast::IdentifierExpr &>(*bin.getLHS())};
+      const sema::Symbol *symbol{CurrentScope->lookup(id.getName())};
+      ast::ExprPtr value{transformExpr(*bin.getRHS())};
+      ValueNumber vn{Numbers.lookup(value.get())};
+      Values[symbol] = vn;
+      if (!isHeld(vn)) {
+        Holders[vn] = symbol;
+      }
+      ast::ExprPtr result{std::make_unique<ast::BinaryExpr>(
+          ast::BinaryExpr::Op::Assign,
+          std::make_unique<ast::IdentifierExpr>(id.getName()), std::move(value),
+          bin.getRange())};
+      WithEffects.insert(result.get());
+      return record(std::move(result), vn);
+    }
+
+    ast::ExprPtr lhs{transformExpr(*bin.getLHS())};
+    ast::ExprPtr rhs{transformExpr(*bin.getRHS())};
+    ValueNumber lhsVN{Numbers.lookup(lhs.get())};
+    ValueNumber rhsVN{Numbers.lookup(rhs.get())};
+    bool lhsEffects{WithEffects.contains(lhs.get())};
+    bool rhsEffects{WithEffects.contains(rhs.get())};
+    // Constant operands with effects are assignments, which must be kept
+    std::optional<double> lhsConstant{
+        lhsEffects ? std::nullopt : Constants[lhsVN]};
+    std::optional<double> rhsConstant{
+        rhsEffects ? std::nullopt : Constants[rhsVN]};
+    if (lhsConstant && rhsConstant) {
+      if (std::optional<llvm::APFloat> folded{
+              Apply(bin.getOp(), ToAPFloat(*lhsConstant, Precision),
+                    ToAPFloat(*rhsConstant, Precision))}) {
+        return makeNumber(folded->convertToDouble(), bin.getRange());
+      }
+    }
+    if (rhsConstant && isIdentity(bin.getOp(), *rhsConstant, true)) {
+      return lhs;
+    }
+    if (lhsConstant && isIdentity(bin.getOp(), *lhsConstant, false)) {
+      return rhs;
+    }
+
+    llvm::SmallString<32> signature;
+    llvm::raw_svector_ostream{signature}
+        << static_cast<unsigned>(bin.getOp()) << ' ' << lhsVN << ' ' << rhsVN;
+    ValueNumber vn{getValueNumber(signature)};
+    bool effects{lhsEffects || rhsEffects};
+    if (!effects && isHeld(vn)) {
+      return makeRead(vn, Holders[vn]);
+    }
+    ast::ExprPtr result{std::make_unique<ast::BinaryExpr>(
+        bin.getOp(), std::move(lhs), std::move(rhs), bin.getRange())};
+    if (effects) {
+      WithEffects.insert(result.get());
+    }
+    return record(std::move(result), vn);
+  }
+
+  /// Only one branch is evaluated, but neither may assign a variable, so the
+  /// values known after the ConditionalExpr are those known before it
+  ast::ExprPtr transformConditionalExpr(const ast::ConditionalExpr &cond) {
+    ast::ExprPtr condExpr{transformExpr(*cond.getCond())};
+    ast::ExprPtr thenExpr{transformExpr(*cond.getThen())};
+    ast::ExprPtr elseExpr{transformExpr(*cond.getElse())};
+    ValueNumber condVN{Numbers.lookup(condExpr.get())};
+    bool condEffects{WithEffects.contains(condExpr.get())};
+    if (std::optional<double> constant{
+            condEffects ? std::nullopt : Constants[condVN]}) {
+      return *constant != 0 ? std::move(thenExpr) : std::move(elseExpr);
+    }
+
+    llvm::SmallString<32> signature;
+    llvm::raw_svector_ostream{signature}
+        << "? " << condVN << ' ' << Numbers.lookup(thenExpr.get()) << ' '
+        << Numbers.lookup(elseExpr.get());
+    ValueNumber vn{getValueNumber(signature)};
+    bool effects{condEffects || WithEffects.contains(thenExpr.get()) ||
+                 WithEffects.contains(elseExpr.get())};
+    if (!effects && isHeld(vn)) {
+      return makeRead(vn, Holders[vn]);
+    }
+    ast::ExprPtr result{std::make_unique<ast::ConditionalExpr>(
+        std::move(condExpr), std::move(thenExpr), std::move(elseExpr),
+        cond.getRange())};
+    if (effects) {
+      WithEffects.insert(result.get());
+    }
+    return record(std::move(result), vn);
+  }
+
+  /// The body is rewritten once for every iteration, so the variables it
+  /// assigns, like the loop variable, hold unknown values when it starts. They
+  /// are unknown after the loop too, which may not run, except for the loop
+  /// variable, which gets its value from before the loop back. Dead
+  /// assignments are removed later, together with the enclosing body
+  ast::StmtPtr transformForStmt(const ast::ForStmt &fs) {
+    ast::ExprPtr start{transformExpr(*fs.getStart())};
+    ast::ExprPtr end{transformExpr(*fs.getEnd())};
+
+    const sema::Symbol *var{CurrentScope->lookup(fs.getVar())};
+    std::vector<const sema::Symbol *> assigned{
+        sema::GetAssignedVars(fs, *CurrentScope)};
+    std::optional<ValueNumber> outer;
+    if (auto it{Values.find(var)}; it != Values.end()) {
+      outer = it->second;
+    }
+    forget(assigned);
+    forget(var);
+
+    std::vector<ast::StmtPtr> stmts;
+    for (const ast::StmtPtr &stmt : fs.getBody()->getStmts()) {
+      stmts.push_back(transformStmt(*stmt));
+    }
+
+    forget(assigned);
+    if (outer) {
+      Values[var] = *outer;
+    } else {
+      Values.erase(var);
+    }
+    return std::make_unique<ast::ForStmt>(
+        fs.getVar(), std::move(start), std::move(end),
+        std::make_unique<ast::CompoundStmt>(std::move(stmts),
+                                            fs.getBody()->getRange()),
+        fs.getRange());
+  }
+
+private:
+  using ValueNumber = unsigned;
+
+  /// Give the variable a new, unknown value
+  void forget(const sema::Symbol *symbol) {
+    ValueNumber vn{makeValueNumber(std::nullopt)};
+    Values[symbol] = vn;
+    Holders[vn] = symbol;
+  }
+
+  void forget(llvm::ArrayRef<const sema::Symbol *> symbols) {
+    for (const sema::Symbol *symbol : symbols) {
+      forget(symbol);
+    }
+  }
+
+  ValueNumber makeValueNumber(std::optional<double> constant) {
+    Constants.push_back(constant);
+    Holders.push_back(nullptr);
+    return Constants.size() - 1;
+  }
+
+  ValueNumber getValueNumber(llvm::StringRef signature) {
+    auto [it, inserted]{Signatures.try_emplace(signature, 0)};
+    if (inserted) {
+      it->second = makeValueNumber(std::nullopt);
+    }
+    return it->second;
+  }
+
+  ast::ExprPtr record(ast::ExprPtr expr, ValueNumber vn) {
+    Numbers[expr.get()] = vn;
+    return expr;
+  }
+
+  ast::ExprPtr makeNumber(double value, source::Range range) {
+    value = Round(value, Precision);
+    auto [it, inserted]{ConstantNumbers.try_emplace(
+        llvm::APFloat{value}.bitcastToAPInt().getZExtValue(), 0)};
+    if (inserted) {
+      it->second = makeValueNumber(value);
+    }
+    return record(std::make_unique<ast::NumberExpr>(value, range), it->second);
+  }
+
+  /// Whether a variable currently holds the value
+  bool isHeld(ValueNumber vn) const {
+    const sema::Symbol *holder{Holders[vn]};
+    if (!holder) {
+      return false;
+    }
+    auto it{Values.find(holder)};
+    return it != Values.end() && it->second == vn;
+  }
+
+  /// Read the value from the variable holding it, which becomes the given
+  /// variable if none does
+  ast::ExprPtr makeRead(ValueNumber vn, const sema::Symbol *symbol) {
+    if (!isHeld(vn)) {
+      Holders[vn] = symbol;
+    }
+    return record(std::make_unique<ast::IdentifierExpr>(Holders[vn]->getName()),
+                  vn);
+  }
+
+  /// Add the variables read by the Expression or Statement to the live set
+  void addReads(const ast::Node &node,
+                llvm::DenseSet<const sema::Symbol *> &live) {
+    switch (node.getKind()) {
+    case ast::Node::Kind::NumberExpr:
+      return;
+    case ast::Node::Kind::IdentifierExpr: {
+      const auto &id{static_cast<const ast::IdentifierExpr &>(node)};
+      live.insert(CurrentScope->lookup(id.getName()));
+      return;
+    }
+    case ast::Node::Kind::CallExpr:
+      for (const ast::ExprPtr &arg :
+           static_cast<const ast::CallExpr &>(node).getArgs()) {
+        addReads(*arg, live);
+      }
+      return;
+    case ast::Node::Kind::BinaryExpr: {
+      const auto &bin{static_cast<const ast::BinaryExpr &>(node)};
+      if (bin.getOp() != ast::BinaryExpr::Op::Assign) {
+        addReads(*bin.getLHS(), live);
+      }
+      addReads(*bin.getRHS(), live);
+      return;
+    }
+    case ast::Node::Kind::ConditionalExpr: {
+      const auto &cond{static_cast<const ast::ConditionalExpr &>(node)};
+      addReads(*cond.getCond(), live);
+      addReads(*cond.getThen(), live);
+      addReads(*cond.getElse(), live);
+      return;
+    }
+    case ast::Node::Kind::ExprStmt:
+      addReads(*static_cast<const ast::ExprStmt &>(node).getExpr(), live);
+      return;
+    case ast::Node::Kind::ReturnStmt:
+      addReads(*static_cast<const ast::ReturnStmt &>(node).getValue(), live);
+      return;
+    case ast::Node::Kind::CompoundStmt:
+      for (const ast::StmtPtr &stmt :
+           static_cast<const ast::CompoundStmt &>(node).getStmts()) {
+        addReads(*stmt, live);
+      }
+      return;
+    case ast::Node::Kind::ForStmt: {
+      const auto &fs{static_cast<const ast::ForStmt &>(node)};
+      addReads(*fs.getStart(), live);
+      addReads(*fs.getEnd(), live);
+      addReads(*fs.getBody(), live);
+      return;
+    }
+    case ast::Node::Kind::ParamDecl:
+    case ast::Node::Kind::FunctionDecl:
+    case ast::Node::Kind::TranslationUnit:
+      break;
+    }
+    MUA_COVERS_ALL_CASES;
+  }
+
+  /// Remove, walking backwards, the Statements assigning a variable that is
+  /// not read afterwards and the Statements without effects. The assigned
+  /// value is kept if it has effects of its own. The live set holds the
+  /// variables read after the Statements
+  std::vector<ast::StmtPtr>
+  eliminateDeadAssignments(std::vector<ast::StmtPtr> stmts,
+                           llvm::DenseSet<const sema::Symbol *> live = {}) {
+    std::vector<ast::StmtPtr> kept;
+    for (ast::StmtPtr &stmt : llvm::reverse(stmts)) {
+      if (const auto *rs{llvm::dyn_cast<ast::ReturnStmt>(stmt.get())}) {
+        addReads(*rs->getValue(), live);
+        kept.push_back(std::move(stmt));
+        continue;
+      }
+      if (const auto *fs{llvm::dyn_cast<ast::ForStmt>(stmt.get())}) {
+        if (ast::StmtPtr loop{eliminateDeadAssignments(*fs, live)}) {
+          kept.push_back(std::move(loop));
+        }
+        continue;
+      }
+      const ast::Expr &expr{*llvm::cast<ast::ExprStmt>(*stmt).getExpr()};
+      const auto *bin{llvm::dyn_cast<ast::BinaryExpr>(&expr)};
+      if (bin && bin->getOp() == ast::BinaryExpr::Op::Assign) {
+        const auto &id{
+            static_cast<const ast::IdentifierExpr &>(*bin->getLHS())};
+        const sema::Symbol *symbol{CurrentScope->lookup(id.getName())};
+        if (live.erase(symbol)) {
+          addReads(*bin->getRHS(), live);
+          kept.push_back(std::move(stmt));
+        } else if (hasEffects(*bin->getRHS())) {
+          addReads(*bin->getRHS(), live);
+          kept.push_back(
+              std::make_unique<ast::ExprStmt>(ast::Clone(*bin->getRHS())));
+        }
+      } else if (hasEffects(expr)) {
+        addReads(expr, live);
+        kept.push_back(std::move(stmt));
+      }
+    }
+    std::reverse(kept.begin(), kept.end());
+    return kept;
+  }
+
+  /// Remove the dead assignments of a loop body, whose reads are live in every
+  /// iteration, given the variables read after the loop. The loop itself is
+  /// removed if its body becomes empty and its bounds have no effects.
+  /// Nothing is killed, as the loop may not run
+  ast::StmtPtr
+  eliminateDeadAssignments(const ast::ForStmt &fs,
+                           llvm::DenseSet<const sema::Symbol *> &live) {
+    const sema::Symbol *var{CurrentScope->lookup(fs.getVar())};
+    llvm::DenseSet<const sema::Symbol *> bodyLive{live};
+    addReads(*fs.getBody(), bodyLive);
+
+    std::vector<ast::StmtPtr> stmts;
+    for (const ast::StmtPtr &stmt : fs.getBody()->getStmts()) {
+      stmts.push_back(ast::Clone(*stmt));
+    }
+    stmts = eliminateDeadAssignments(std::move(stmts), std::move(bodyLive));
+    if (stmts.empty() && !hasEffects(*fs.getStart()) &&
+        !hasEffects(*fs.getEnd())) {
+      return nullptr;
+    }
+
+    auto body{std::make_unique<ast::CompoundStmt>(std::move(stmts),
+                                                  fs.getBody()->getRange())};
+    // The body reads its own loop variable, not the one outside the loop
+    llvm::DenseSet<const sema::Symbol *> reads;
+    addReads(*body, reads);
+    reads.erase(var);
+    live.insert(reads.begin(), reads.end());
+    addReads(*fs.getStart(), live);
+    addReads(*fs.getEnd(), live);
+    return std::make_unique<ast::ForStmt>(
+        fs.getVar(), ast::Clone(*fs.getStart()), ast::Clone(*fs.getEnd()),
+        std::move(body), fs.getRange());
+  }
+
+  const sema::Scope &GlobalScope;
+  FPPrecision Precision;
+  const sema::Scope *CurrentScope{nullptr};
+
+  /// ValueNumber of every rewritten Expression
+  llvm::DenseMap<const ast::Expr *, ValueNumber> Numbers;
+  /// Constant value of each ValueNumber, if known
+  std::vector<std::optional<double>> Constants;
+  /// Variable that held each ValueNumber when last assigned or read, if any
+  std::vector<const sema::Symbol *> Holders;
+  /// ValueNumbers of operations, by operator and operand ValueNumbers
+  llvm::StringMap<ValueNumber> Signatures;
+  /// ValueNumbers of constants, by bit pattern
+  llvm::DenseMap<std::uint64_t, ValueNumber> ConstantNumbers;
+  /// Current ValueNumber of every assigned variable
+  llvm::DenseMap<const sema::Symbol *, ValueNumber> Values;
+  /// Rewritten Expressions with effects (see hasEffects)
+  llvm::DenseSet<const ast::Expr *> WithEffects;
+};
+
+} // namespace
+
+std::unique_ptr<ast::TranslationUnit>
+mua::transform::Simplify(const ast::TranslationUnit &tu,
+                         const sema::Scope &scope, FPPrecision precision) {
+  Simplifier simplifier{scope, precision};
+  return simplifier.transformTranslationUnit(tu);
+}
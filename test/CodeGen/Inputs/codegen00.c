@@ -0,0 +1,11 @@
+#include <stdio.h>
+
+double foo(double, double);
+double bar(double);
+
+int main(void) {
+  printf("%g\n", foo(3, 5));
+  printf("%g\n", bar(2));
+  printf("%g\n", foo(-1, 0.5));
+  return 0;
+}
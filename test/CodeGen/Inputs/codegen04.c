@@ -0,0 +1,9 @@
+#include <stdio.h>
+
+int main(void) {
+  double grad[2];
+  printf("%g\n", m_poly(3, 5));
+  printf("%g\n", m_poly_grad(3, 5, grad));
+  printf("%g %g\n", grad[0], grad[1]);
+  return 0;
+}
@@ -0,0 +1,21 @@
+#include <stdio.h>
+#include <string.h>
+
+int main(void) {
+  const double args[] = {3, 4};
+  const char *names[] = {"area", "square", "three", "are", "areas",
+                         "",     "mua_lookup", "m_area"};
+  for (size_t i = 0; i < sizeof(names) / sizeof(*names); ++i) {
+    const struct mua_function *function =
+        m_mua_lookup(names[i], strlen(names[i]));
+    if (!function) {
+      printf("%s: not found\n", names[i]);
+      continue;
+    }
+    printf("%s/%llu: %g\n", function->name,
+           (unsigned long long)function->arity, function->call(args));
+  }
+  printf("same function: %d\n",
+         m_mua_lookup("area", 4)->function == (const void *)m_area);
+  return 0;
+}
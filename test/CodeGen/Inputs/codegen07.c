@@ -0,0 +1,12 @@
+#include <stdio.h>
+
+double two_grad(double *);
+double scale_grad(double, double, double *);
+
+int main(void) {
+  double grad[2];
+  printf("%g\n", two_grad(NULL));
+  printf("%g\n", scale_grad(3, 2, grad));
+  printf("%g %g\n", grad[0], grad[1]);
+  return 0;
+}
@@ -9,6 +9,9 @@ config.test_format = lit.formats.ShTest(execute_external=False)
 
 config.suffixes = [".mua"]
 
+# Inputs hold the files shared by tests, which are no tests themselves
+config.excludes = ["Inputs"]
+
 config.test_source_root = os.path.dirname(__file__)
 config.test_exec_root = config.mua_binary_test_dir
 
@@ -23,4 +26,12 @@ llvm_config.add_tool_substitutions(
     ]
 )
 
+for target in config.targets_to_build.split(";"):
+    config.available_features.add(target.lower() + "-registered-target")
+if config.host_triple.startswith("x86_64"):
+    config.available_features.add("host-x86_64")
+
+# C compiler linking emitted objects into test harnesses
+config.substitutions.append(("%cc", config.host_cc))
+
 llvm_config.with_environment("PATH", config.llvm_tools_dir, append_path=True)
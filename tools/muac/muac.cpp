@@ -21,21 +21,44 @@
 // SOFTWARE.
 
 #include "mua/AST/TranslationUnit.h"
+#include "mua/CodeGen/CodeGen.h"
 #include "mua/Lower/IRUnit.h"
 #include "mua/Lower/Lower.h"
 #include "mua/Parser/Parser.h"
 #include "mua/Sema/Sema.h"
+#include "mua/Sema/Session.h"
 #include "mua/Sema/Symbol.h"
 #include "mua/Source/File.h"
+#include "mua/Support/ErrorHandling.h"
+#include "mua/Transform/ConstEval.h"
+#include "mua/Transform/Rewrite.h"
+#include "mua/Transform/Simplify.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetMachine.h"
+#include <optional>
 
 static llvm::cl::opt<std::string> InputFilename{
     llvm::cl::Positional, llvm::cl::desc{"<input mua file>"},
     llvm::cl::init("-"), llvm::cl::value_desc{"filename"}};
 
 namespace {
-enum class Action { None, DumpAST, DumpSema, DumpLLVM };
+enum class Action {
+  None,
+  DumpAST,
+  DumpSema,
+  DumpLLVM,
+  EmitBC,
+  EmitAsm,
+  EmitObj,
+  EmitLib,
+  EmitHeader,
+  EmitCost
+};
 } // namespace
 
 static llvm::cl::opt<enum Action> EmitAction(
@@ -46,7 +69,325 @@ static llvm::cl::opt<enum Action> EmitAction(
     llvm::cl::values(clEnumValN(Action::DumpSema, "sema",
                                 "Emit the semantic representation")),
     llvm::cl::values(clEnumValN(Action::DumpLLVM, "llvm",
-                                "Emit the LLVM IR module")));
+                                "Emit the LLVM IR module")),
+    llvm::cl::values(clEnumValN(Action::EmitBC, "bc",
+                                "Emit the LLVM IR module as bitcode")),
+    llvm::cl::values(clEnumValN(Action::EmitAsm, "asm",
+                                "Emit native assembly")),
+    llvm::cl::values(clEnumValN(Action::EmitObj, "obj",
+                                "Emit a native object file")),
+    llvm::cl::values(clEnumValN(Action::EmitLib, "lib",
+                                "Emit a native static library")),
+    llvm::cl::values(clEnumValN(Action::EmitHeader, "header",
+                                "Emit a C header declaring the exported "
+                                "functions")),
+    llvm::cl::values(clEnumValN(Action::EmitCost, "cost",
+                                "Emit the estimated cost of every function "
+                                "after optimization")));
+
+static llvm::cl::opt<mua::codegen::CostFormat> CostReportFormat(
+    "cost-format", llvm::cl::desc{"Select the format of -emit=cost"},
+    llvm::cl::init(mua::codegen::CostFormat::Text),
+    llvm::cl::values(clEnumValN(mua::codegen::CostFormat::Text, "text",
+                                "Aligned table (default)")),
+    llvm::cl::values(clEnumValN(mua::codegen::CostFormat::JSON, "json",
+                                "JSON, also readable by -cost-baseline")));
+
+static llvm::cl::opt<std::string> CostBaseline{
+    "cost-baseline",
+    llvm::cl::desc{"Report the changes of -emit=cost from an earlier JSON "
+                   "report"},
+    llvm::cl::value_desc{"filename"}};
+
+static llvm::cl::opt<std::string> OutputFilename{
+    "o", llvm::cl::desc{"Output file (default: standard output)"},
+    llvm::cl::init("-"), llvm::cl::value_desc{"filename"}};
+
+static llvm::cl::opt<std::string> TargetTriple{
+    "mtriple", llvm::cl::desc{"Target triple of native code (default: host)"},
+    llvm::cl::value_desc{"triple"}};
+
+static llvm::cl::opt<std::string> TargetCPU{
+    "mcpu",
+    llvm::cl::desc{"Target CPU of native code, or native for the host CPU"},
+    llvm::cl::init("generic"), llvm::cl::value_desc{"cpu"}};
+
+static llvm::cl::list<std::string> MultiversionLevels{
+    "multiversion",
+    llvm::cl::desc{"Also specialize functions for each x86-64 "
+                   "microarchitecture level, selected at load time"},
+    llvm::cl::CommaSeparated, llvm::cl::value_desc{"level"}};
+
+static llvm::cl::opt<llvm::Reloc::Model> RelocModel(
+    "relocation-model", llvm::cl::desc{"Relocation model of native code"},
+    llvm::cl::init(llvm::Reloc::PIC_),
+    llvm::cl::values(clEnumValN(llvm::Reloc::Static, "static",
+                                "Non-relocatable code")),
+    llvm::cl::values(clEnumValN(llvm::Reloc::PIC_, "pic",
+                                "Position-independent code")));
+
+static llvm::cl::opt<unsigned> Threads{
+    "j",
+    llvm::cl::desc{"Split the module and compile its partitions on N threads "
+                   "(0: one per hardware thread). -emit=lib then archives "
+                   "one object per partition"},
+    llvm::cl::value_desc{"N"}};
+
+static llvm::cl::opt<unsigned> PartitionSize{
+    "partition-size",
+    llvm::cl::desc{"Instructions from which a partition is not grown with -j"},
+    llvm::cl::init(1000), llvm::cl::Hidden};
+
+static llvm::cl::list<std::string> Exports{
+    "export",
+    llvm::cl::desc{"Functions visible outside of the module (default: all)"},
+    llvm::cl::CommaSeparated, llvm::cl::value_desc{"function"}};
+
+static llvm::cl::opt<std::string> SymbolPrefix{
+    "symbol-prefix",
+    llvm::cl::desc{"Prefix the symbols of exported functions, so that several "
+                   "modules can be linked together"},
+    llvm::cl::value_desc{"prefix"}};
+
+static llvm::cl::opt<bool> WarnPerf{
+    "Wperf", llvm::cl::desc{"Warn about code that is correct but slow"}};
+
+static llvm::cl::opt<mua::lower::FPModel> FloatingPointModel(
+    "ffp-model", llvm::cl::desc{"Select the floating-point model"},
+    llvm::cl::init(mua::lower::FPModel::Precise),
+    llvm::cl::values(clEnumValN(
+        mua::lower::FPModel::Strict, "strict",
+        "IEEE semantics with exceptions and dynamic rounding")),
+    llvm::cl::values(clEnumValN(mua::lower::FPModel::Precise, "precise",
+                                "IEEE semantics (default)")),
+    llvm::cl::values(clEnumValN(mua::lower::FPModel::Fast, "fast",
+                                "Every fast-math optimization")));
+
+static llvm::cl::opt<mua::lower::FPContract> FloatingPointContraction(
+    "ffp-contract",
+    llvm::cl::desc{"Select the fusion of multiplications and additions "
+                   "(default: fast with -ffp-model=fast, off otherwise)"},
+    llvm::cl::init(mua::lower::FPContract::Off),
+    llvm::cl::values(clEnumValN(mua::lower::FPContract::Off, "off",
+                                "Never fuse")),
+    llvm::cl::values(clEnumValN(mua::lower::FPContract::On, "on",
+                                "Fuse within expressions")),
+    llvm::cl::values(clEnumValN(mua::lower::FPContract::Fast, "fast",
+                                "Fuse across statements")));
+
+static llvm::cl::opt<mua::FPPrecision> Precision(
+    "fp-precision", llvm::cl::desc{"Select the format of numbers"},
+    llvm::cl::init(mua::FPPrecision::F64),
+    llvm::cl::values(clEnumValN(mua::FPPrecision::F32, "f32",
+                                "Single precision (float)")),
+    llvm::cl::values(clEnumValN(mua::FPPrecision::F64, "f64",
+                                "Double precision (double, default)")));
+
+static llvm::cl::list<std::string> ReanalyzeFilenames{
+    "reanalyze",
+    llvm::cl::desc{"With -emit=sema, analyze these files in turn as new "
+                   "versions of the input, reusing the analysis of unchanged "
+                   "functions, and report the functions analyzed again"},
+    llvm::cl::value_desc{"filenames"}, llvm::cl::CommaSeparated};
+
+static llvm::cl::opt<bool> ConstEval{
+    "const-eval",
+    llvm::cl::desc{"Evaluate calls with constant arguments at compile time"}};
+
+static llvm::cl::opt<bool> Gradients{
+    "gradients",
+    llvm::cl::desc{"Also emit f_grad, computing the gradient of f, for every "
+                   "function f"}};
+
+static llvm::cl::opt<bool> DispatchTable{
+    "dispatch-table",
+    llvm::cl::desc{"Also emit mua_lookup, finding exported functions by name "
+                   "in a perfect-hashed table"}};
+
+namespace {
+enum class OptLevel { O0, O1, O2, O3, Os, O1Fast };
+} // namespace
+
+static llvm::cl::opt<enum OptLevel> OptimizationLevel(
+    llvm::cl::desc{"Select the optimization level"},
+    llvm::cl::init(OptLevel::O0),
+    llvm::cl::values(clEnumValN(OptLevel::O0, "O0", "No optimization")),
+    llvm::cl::values(clEnumValN(OptLevel::O1, "O1", "Light optimization")),
+    llvm::cl::values(clEnumValN(OptLevel::O2, "O2", "Default optimization")),
+    llvm::cl::values(clEnumValN(OptLevel::O3, "O3", "Aggressive optimization")),
+    llvm::cl::values(clEnumValN(OptLevel::Os, "Os", "Optimize for size")),
+    llvm::cl::values(clEnumValN(
+        OptLevel::O1Fast, "O1-fast",
+        "Fast AST-level simplifications only, for low compile latency")));
+
+/// LLVM pass pipeline of an optimization level
+static mua::lower::OptLevel GetLLVMOptLevel(OptLevel level) {
+  switch (level) {
+  case OptLevel::O0:
+  case OptLevel::O1Fast:
+    return mua::lower::OptLevel::O0;
+  case OptLevel::O1:
+    return mua::lower::OptLevel::O1;
+  case OptLevel::O2:
+    return mua::lower::OptLevel::O2;
+  case OptLevel::O3:
+    return mua::lower::OptLevel::O3;
+  case OptLevel::Os:
+    return mua::lower::OptLevel::Os;
+  }
+  MUA_COVERS_ALL_CASES;
+}
+
+static llvm::cl::opt<double> CompileBudget{
+    "compile-budget",
+    llvm::cl::desc{"Pick the optimization level (O0, O1 or O3) of each "
+                   "function so that optimization and code generation are "
+                   "estimated to take at most this many milliseconds"},
+    llvm::cl::value_desc{"ms"}};
+
+static llvm::cl::opt<bool> CompileBudgetReport{
+    "compile-budget-report",
+    llvm::cl::desc{"Report the level picked for each function by "
+                   "-compile-budget"}};
+
+namespace {
+enum class RewriteMode { None, Strict, Fast };
+} // namespace
+
+static llvm::cl::opt<enum RewriteMode> RewriteRules(
+    "rewrite", llvm::cl::desc{"Select the algebraic rewrites to apply"},
+    llvm::cl::init(RewriteMode::None),
+    llvm::cl::values(clEnumValN(RewriteMode::None, "none", "No rewrites")),
+    llvm::cl::values(clEnumValN(RewriteMode::Strict, "strict",
+                                "Only rewrites preserving IEEE results")),
+    llvm::cl::values(clEnumValN(RewriteMode::Fast, "fast",
+                                "Also reassociate and use reciprocals")));
+
+namespace {
+
+/// Buffered output file of the compiler. Files are written to a temporary file
+/// that is only renamed over them once complete, so that failed compilations
+/// never leave partial outputs behind
+class OutputFile final {
+public:
+  /// Open an output file, or standard output if its name is "-". On failure,
+  /// returns nullptr and writes diagnostics to the provided output stream
+  static std::unique_ptr<OutputFile> Open(llvm::StringRef filename, bool text,
+                                          llvm::raw_ostream &errs) {
+    std::unique_ptr<OutputFile> outputFile{new OutputFile{filename}};
+    llvm::sys::fs::OpenFlags flags{text ? llvm::sys::fs::OF_Text
+                                        : llvm::sys::fs::OF_None};
+    if (filename == "-") {
+      std::error_code ec;
+      outputFile->Stream =
+          std::make_unique<llvm::raw_fd_ostream>(filename, ec, flags);
+      if (ec) {
+        errs << "error: could not open file " << filename << ": "
+             << ec.message() << '\n';
+        return nullptr;
+      }
+      return outputFile;
+    }
+
+    llvm::Expected<llvm::sys::fs::TempFile> tempFile{
+        llvm::sys::fs::TempFile::create(filename + ".tmp%%%%%%%%",
+                                        llvm::sys::fs::all_read |
+                                            llvm::sys::fs::all_write,
+                                        flags)};
+    if (!tempFile) {
+      errs << "error: could not open file " << filename << ": "
+           << llvm::toString(tempFile.takeError()) << '\n';
+      return nullptr;
+    }
+    outputFile->TempFile.emplace(std::move(*tempFile));
+    outputFile->Stream = std::make_unique<llvm::raw_fd_ostream>(
+        outputFile->TempFile->FD, /*shouldClose=*/false);
+    return outputFile;
+  }
+
+  ~OutputFile() {
+    // Outputs that were not kept are incomplete
+    Stream->clear_error();
+    Stream.reset();
+    if (TempFile) {
+      llvm::consumeError(TempFile->discard());
+    }
+  }
+
+  llvm::raw_fd_ostream &getStream() { return *Stream; }
+
+  /// Flush the output and move it into place. On failure, returns false and
+  /// writes diagnostics to the provided output stream
+  bool keep(llvm::raw_ostream &errs) {
+    Stream->flush();
+    if (std::error_code ec{Stream->error()}) {
+      errs << "error: could not write file " << Filename << ": "
+           << ec.message() << '\n';
+      return false;
+    }
+    if (!TempFile) {
+      return true;
+    }
+    if (llvm::Error error{TempFile->keep(Filename)}) {
+      errs << "error: could not write file " << Filename << ": "
+           << llvm::toString(std::move(error)) << '\n';
+      return false;
+    }
+    TempFile.reset();
+    return true;
+  }
+
+private:
+  explicit OutputFile(llvm::StringRef filename) : Filename{filename} {}
+
+  std::string Filename;
+  std::optional<llvm::sys::fs::TempFile> TempFile;
+  std::unique_ptr<llvm::raw_fd_ostream> Stream;
+};
+
+} // namespace
+
+/// Analyze a TranslationUnit, then every file of -reanalyze in turn, with a
+/// single Session, as successive versions of the same source. Each analysis
+/// reports the functions whose bodies it analyzed, and the Scope of the last
+/// version is dumped to the given output stream. Returns the exit code
+static int Reanalyze(const mua::ast::TranslationUnit &tu,
+                     llvm::raw_ostream &os) {
+  mua::sema::Session session;
+  auto analyze{[&](const mua::ast::TranslationUnit &version) {
+    const mua::sema::Scope *scope{session.analyze(version, llvm::errs())};
+    llvm::errs() << "analyzed:";
+    for (const std::string &name : session.getAnalyzed()) {
+      llvm::errs() << ' ' << name;
+    }
+    llvm::errs() << '\n';
+    return scope;
+  }};
+  const mua::sema::Scope *scope{analyze(tu)};
+  if (!scope) {
+    return 4;
+  }
+  // Reused Scopes are relocated into the newest version, but every version is
+  // kept alive until the end for simplicity
+  std::vector<std::unique_ptr<mua::source::File>> files;
+  std::vector<std::unique_ptr<mua::ast::TranslationUnit>> versions;
+  for (const std::string &filename : ReanalyzeFilenames) {
+    files.push_back(mua::source::File::Open(filename, llvm::errs()));
+    if (!files.back()) {
+      return 2;
+    }
+    versions.push_back(mua::parser::Parse(*files.back(), llvm::errs()));
+    if (!versions.back()) {
+      return 3;
+    }
+    scope = analyze(*versions.back());
+    if (!scope) {
+      return 4;
+    }
+  }
+  mua::sema::Dump(*scope, os);
+  return 0;
+}
 
 int main(int argc, char *argv[]) {
   llvm::InitLLVM initLLVM{argc, argv};
@@ -55,6 +396,47 @@ int main(int argc, char *argv[]) {
     return 1;
   }
 
+  std::unique_ptr<OutputFile> output;
+  if (EmitAction != Action::None) {
+    output = OutputFile::Open(OutputFilename,
+                              EmitAction != Action::EmitBC &&
+                                  EmitAction != Action::EmitObj &&
+                                  EmitAction != Action::EmitLib,
+                              llvm::errs());
+    if (!output) {
+      return 2;
+    }
+    if (EmitAction == Action::EmitBC && output->getStream().is_displayed()) {
+      llvm::errs() << "error: refusing to write bitcode to a terminal; use "
+                      "-o to select an output file\n";
+      return 1;
+    }
+  }
+
+  if ((CostReportFormat.getNumOccurrences() ||
+       CostBaseline.getNumOccurrences()) &&
+      EmitAction != Action::EmitCost) {
+    llvm::errs() << "error: -cost-format and -cost-baseline require "
+                    "-emit=cost\n";
+    return 1;
+  }
+  if (!ReanalyzeFilenames.empty() && EmitAction != Action::DumpSema) {
+    llvm::errs() << "error: -reanalyze requires -emit=sema\n";
+    return 1;
+  }
+  if (Threads.getNumOccurrences() && EmitAction == Action::EmitObj) {
+    llvm::errs() << "error: -j compiles partitions to separate objects; use "
+                    "-emit=lib to archive them\n";
+    return 1;
+  }
+  std::optional<std::vector<mua::codegen::FunctionCost>> baselineCosts;
+  if (CostBaseline.getNumOccurrences()) {
+    baselineCosts = mua::codegen::ReadCostReport(CostBaseline, llvm::errs());
+    if (!baselineCosts) {
+      return 2;
+    }
+  }
+
   std::unique_ptr<mua::source::File> file{
       mua::source::File::Open(InputFilename, llvm::errs())};
   if (!file) {
@@ -67,26 +449,207 @@ int main(int argc, char *argv[]) {
     return 3;
   }
   if (EmitAction == Action::DumpAST) {
-    mua::ast::Dump(*translationUnit, llvm::errs());
-    return 0;
+    mua::ast::Dump(*translationUnit, output->getStream());
+    return output->keep(llvm::errs()) ? 0 : 2;
   }
 
+  if (!ReanalyzeFilenames.empty()) {
+    int status{Reanalyze(*translationUnit, output->getStream())};
+    if (status != 0) {
+      return status;
+    }
+    return output->keep(llvm::errs()) ? 0 : 2;
+  }
   std::unique_ptr<mua::sema::Scope> scope{
       mua::sema::Analyze(*translationUnit, llvm::errs())};
   if (!scope) {
     return 4;
   }
+  if (WarnPerf) {
+    mua::sema::Lint(*translationUnit, *scope, llvm::errs());
+  }
   if (EmitAction == Action::DumpSema) {
-    mua::sema::Dump(*scope, llvm::errs());
-    return 0;
+    mua::sema::Dump(*scope, output->getStream());
+    return output->keep(llvm::errs()) ? 0 : 2;
+  }
+
+  // Compile-time evaluation rounds to nearest and ignores floating-point
+  // exceptions, so it would break the guarantees of the Strict model
+  if (FloatingPointModel == mua::lower::FPModel::Strict &&
+      (ConstEval || RewriteRules != RewriteMode::None ||
+       OptimizationLevel == OptLevel::O1Fast)) {
+    llvm::errs() << "error: -const-eval, -rewrite and -O1-fast cannot be "
+                    "combined with -ffp-model=strict\n";
+    return 1;
+  }
+  if (ConstEval) {
+    translationUnit =
+        mua::transform::EvaluateConstantCalls(*translationUnit, Precision);
+  }
+  if (RewriteRules != RewriteMode::None) {
+    translationUnit = mua::transform::Rewrite(
+        *translationUnit, *scope,
+        RewriteRules == RewriteMode::Strict
+            ? mua::transform::RewritePolicy::Strict
+            : mua::transform::RewritePolicy::Fast,
+        Precision);
+  }
+  if (OptimizationLevel == OptLevel::O1Fast) {
+    translationUnit =
+        mua::transform::Simplify(*translationUnit, *scope, Precision);
+  }
+
+  bool budgeted{CompileBudget.getNumOccurrences() > 0};
+  if (budgeted && OptimizationLevel.getNumOccurrences()) {
+    llvm::errs() << "error: -compile-budget cannot be combined with an "
+                    "optimization level\n";
+    return 1;
+  }
+  if (budgeted && Threads.getNumOccurrences()) {
+    llvm::errs() << "error: -compile-budget cannot be combined with -j\n";
+    return 1;
+  }
+  std::vector<mua::lower::FunctionOptLevel> levels;
+  if (budgeted) {
+    levels = mua::lower::PlanOptLevels(*translationUnit, *scope, CompileBudget);
+    if (CompileBudgetReport) {
+      mua::lower::ReportOptLevels(levels, CompileBudget, llvm::errs());
+    }
+  }
+
+  if (!SymbolPrefix.empty() &&
+      (llvm::isDigit(SymbolPrefix.front()) ||
+       !llvm::all_of(SymbolPrefix, [](char c) {
+         return llvm::isAlnum(c) || c == '_';
+       }))) {
+    llvm::errs() << "error: symbol prefix " << SymbolPrefix
+                 << " does not start a C identifier\n";
+    return 1;
+  }
+
+  mua::lower::Options options;
+  for (const std::string &name : Exports) {
+    const mua::sema::Symbol *symbol{scope->lookup(name)};
+    if (!symbol || symbol->getKind() != mua::sema::Symbol::Kind::Function) {
+      llvm::errs() << "error: cannot export undeclared function " << name
+                   << '\n';
+      return 5;
+    }
+    options.Exports.push_back(name);
+  }
+  if (Gradients && !mua::sema::CheckGradients(*scope, llvm::errs())) {
+    return 4;
+  }
+  options.Gradients = Gradients;
+  if (DispatchTable && !mua::sema::CheckDispatchTable(*scope, llvm::errs())) {
+    return 4;
+  }
+  options.DispatchTable = DispatchTable;
+  options.FloatingPoint = FloatingPointModel;
+  options.Contraction = FloatingPointContraction;
+  options.Precision = Precision;
+  if (!FloatingPointContraction.getNumOccurrences() &&
+      FloatingPointModel == mua::lower::FPModel::Fast) {
+    options.Contraction = mua::lower::FPContract::Fast;
+  }
+  if (options.FloatingPoint == mua::lower::FPModel::Strict &&
+      options.Contraction != mua::lower::FPContract::Off) {
+    llvm::errs() << "error: -ffp-contract must be off with -ffp-model=strict\n";
+    return 1;
   }
 
   mua::lower::IRUnit theIRUnit{
-      mua::lower::LowerToLLVMIR(*translationUnit, *scope)};
+      mua::lower::LowerToLLVMIR(*translationUnit, *scope, options)};
+  if (EmitAction == Action::EmitHeader) {
+    if (!mua::lower::WriteHeader(theIRUnit, *translationUnit, *scope,
+                                 Precision, SymbolPrefix, output->getStream(),
+                                 llvm::errs())) {
+      return 5;
+    }
+    return output->keep(llvm::errs()) ? 0 : 2;
+  }
+  bool emitNative{EmitAction == Action::EmitAsm ||
+                  EmitAction == Action::EmitObj ||
+                  EmitAction == Action::EmitLib};
+  // Under -j, libraries archive the object of every partition
+  bool emitArchive{EmitAction == Action::EmitLib};
+  mua::codegen::TargetOptions targetOptions;
+  targetOptions.Triple = TargetTriple;
+  targetOptions.CPU = TargetCPU;
+  targetOptions.RelocModel = RelocModel;
+  // Functions left at O0 by -compile-budget are optnone, which the code
+  // generator honors at any level
+  targetOptions.Level = budgeted ? mua::lower::OptLevel::O3
+                                 : GetLLVMOptLevel(OptimizationLevel);
+  std::unique_ptr<llvm::TargetMachine> targetMachine;
+  if (emitNative || EmitAction == Action::EmitCost ||
+      TargetTriple.getNumOccurrences() || TargetCPU.getNumOccurrences() ||
+      !MultiversionLevels.empty()) {
+    targetMachine =
+        mua::codegen::CreateTargetMachine(targetOptions, llvm::errs());
+    if (!targetMachine) {
+      return 6;
+    }
+    mua::codegen::SetTarget(theIRUnit, *targetMachine);
+  }
+  if (!MultiversionLevels.empty() &&
+      !mua::codegen::Multiversion(theIRUnit, MultiversionLevels,
+                                  llvm::errs())) {
+    return 6;
+  }
+  mua::codegen::ParallelOptions parallelOptions;
+  parallelOptions.Threads = Threads;
+  parallelOptions.PartitionSize = PartitionSize;
+  bool parallel{Threads.getNumOccurrences() > 0};
+  if (budgeted) {
+    mua::lower::Optimize(theIRUnit, levels, targetMachine.get());
+  } else if (!parallel) {
+    mua::lower::Optimize(theIRUnit, GetLLVMOptLevel(OptimizationLevel),
+                         targetMachine.get());
+  } else if (!emitArchive) {
+    // Only objects can be combined after code generation, so other outputs
+    // are generated from the partitions linked back together
+    mua::codegen::OptimizeInParallel(
+        theIRUnit, GetLLVMOptLevel(OptimizationLevel),
+        targetMachine ? &targetOptions : nullptr, parallelOptions);
+  }
+  // Costs are reported under the mua names of functions
+  if (EmitAction == Action::EmitCost) {
+    mua::codegen::WriteCostReport(
+        mua::codegen::EstimateCosts(theIRUnit, *targetMachine),
+        baselineCosts ? &*baselineCosts : nullptr, CostReportFormat,
+        output->getStream());
+    return output->keep(llvm::errs()) ? 0 : 2;
+  }
+  // Names are only changed once functions no longer refer to each other by
+  // name, but before objects are generated
+  if (!SymbolPrefix.empty()) {
+    mua::lower::PrefixSymbols(theIRUnit, SymbolPrefix);
+  }
   if (EmitAction == Action::DumpLLVM) {
-    mua::lower::Dump(theIRUnit, llvm::errs());
-    return 0;
+    mua::lower::Dump(theIRUnit, output->getStream());
+  } else if (EmitAction == Action::EmitBC) {
+    mua::lower::WriteBitcode(theIRUnit, output->getStream());
+  } else if (emitNative) {
+    bool emitted;
+    if (parallel && emitArchive) {
+      emitted = mua::codegen::EmitArchive(theIRUnit, targetOptions,
+                                          parallelOptions, output->getStream(),
+                                          llvm::errs());
+    } else if (EmitAction == Action::EmitLib) {
+      emitted = mua::codegen::EmitLibrary(theIRUnit, *targetMachine,
+                                          output->getStream(), llvm::errs());
+    } else {
+      emitted = mua::codegen::Emit(theIRUnit, *targetMachine,
+                                   EmitAction == Action::EmitAsm
+                                       ? mua::codegen::FileKind::Assembly
+                                       : mua::codegen::FileKind::Object,
+                                   output->getStream(), llvm::errs());
+    }
+    if (!emitted) {
+      return 6;
+    }
   }
 
-  return 0;
+  return !output || output->keep(llvm::errs()) ? 0 : 2;
 }